@@ -0,0 +1,85 @@
+/*
+    AdaptiveTimeout
+
+    See AdaptiveTimeout.h
+*/
+#include "AdaptiveTimeout.h"
+
+AdaptiveTimeout::AdaptiveTimeout(uint8_t longTimeoutMs)
+    : _longTimeoutMs(longTimeoutMs), _holdLongUntil(0), _holding(false),
+      _count(0) {
+}
+
+void AdaptiveTimeout::learn(const decode_results &results,
+                            uint32_t nowMillis) {
+    if (results.decode_type == UNKNOWN) {
+        _holding       = true;
+        _holdLongUntil = nowMillis + kAdaptiveHoldLongMs;
+        return;
+    }
+
+    // Longest space inside the message.  rawbuf[0] is the gap before the
+    // message, then it's mark, space, mark, ... so spaces are the even
+    // entries.  The message always ends on a mark.
+    uint32_t longestSpaceUs = 0;
+    for (uint16_t i = 2; i < results.rawlen; i += 2) {
+        uint32_t usecs = (uint32_t)results.rawbuf[i] * kRawTick;
+        if (usecs > longestSpaceUs) {
+            longestSpaceUs = usecs;
+        }
+    }
+
+    uint32_t neededUs = longestSpaceUs +
+                        (longestSpaceUs * kAdaptiveMarginPercent) / 100;
+    uint32_t neededMs = ((neededUs + 999) / 1000) + kAdaptiveMarginMs;
+    neededMs = constrain(neededMs, (uint32_t)kAdaptiveMinTimeoutMs,
+                         (uint32_t)_longTimeoutMs);
+
+    // Update the entry for this protocol, or add one (replacing the one
+    // seen longest ago if the table is full).
+    uint8_t slot = _count;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_learned[i].decodeType == (int16_t)results.decode_type) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == _count) {
+        if (_count < kMaxProtocols) {
+            _count++;
+            _learned[slot].neededMs = 0;
+        } else {
+            slot = 0;
+            for (uint8_t i = 1; i < _count; i++) {
+                if ((nowMillis - _learned[i].lastSeen) >
+                    (nowMillis - _learned[slot].lastSeen)) {
+                    slot = i;
+                }
+            }
+            _learned[slot].neededMs = 0;
+        }
+        _learned[slot].decodeType = (int16_t)results.decode_type;
+    }
+
+    // Only ever grow it, one short message shouldn't undo a longer one.
+    if (neededMs > _learned[slot].neededMs) {
+        _learned[slot].neededMs = (uint8_t)neededMs;
+    }
+    _learned[slot].lastSeen = nowMillis;
+}
+
+uint8_t AdaptiveTimeout::timeoutMs(uint32_t nowMillis) const {
+    if (_holding && ((int32_t)(_holdLongUntil - nowMillis) > 0)) {
+        return _longTimeoutMs;
+    }
+
+    uint8_t timeout = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if ((nowMillis - _learned[i].lastSeen) < kAdaptiveForgetMs) {
+            timeout = max(timeout, _learned[i].neededMs);
+        }
+    }
+
+    // Nothing learned (or all forgotten) -> play it safe
+    return (timeout == 0) ? _longTimeoutMs : timeout;
+}
@@ -0,0 +1,72 @@
+/*
+    AdaptiveTimeout
+
+    IRrecv decides a message has ended once it has seen kTimeout ms of
+    silence.  90 ms is plenty for anything (long A/C messages, multi-part
+    UNKNOWN captures), but it means every NEC press waits 90 ms after its
+    last mark before decode() can return it.
+
+    This learns, per protocol that actually gets decoded, the longest space
+    seen inside its messages, and works out the shortest timeout that would
+    still have kept the message in one piece (plus some margin).  The
+    receiver then runs with the largest of those for the protocols seen
+    recently, which for the usual NEC/XMP/Vizio traffic is the 15 ms floor.
+
+    The long timeout comes back whenever:
+      - nothing has been learned yet, or it's all been forgotten
+        (kAdaptiveForgetMs without seeing that protocol again),
+      - an UNKNOWN capture is seen (it may have been cut short, or it's a
+        protocol we can't decode), for kAdaptiveHoldLongMs.
+
+    NOTE: IRrecv can't end a frame early on its own ("this looks like a
+    complete NEC message"), the end of a message is only ever the timeout.
+    And the timeout can only be set when IRrecv is created, so main.cpp
+    re-creates the receiver when timeoutMs() changes, but only once things
+    have been quiet for a while (so it can't land between the NEC and XMP
+    codes of one XR2 button press).
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+// Never go below IRremoteESP8266's own default timeout
+const uint8_t  kAdaptiveMinTimeoutMs  = kTimeoutMs;
+// Extra time on top of the longest space seen: +25%, +2 ms
+const uint8_t  kAdaptiveMarginPercent = 25;
+const uint8_t  kAdaptiveMarginMs      = 2;
+// Forget a protocol if it hasn't been seen for this long
+const uint32_t kAdaptiveForgetMs      = 60000;
+// Stay on the long timeout this long after an UNKNOWN capture
+const uint32_t kAdaptiveHoldLongMs    = 10000;
+
+class AdaptiveTimeout {
+public:
+    explicit AdaptiveTimeout(uint8_t longTimeoutMs);
+
+    // Feed every decoded capture (UNKNOWN included).
+    void learn(const decode_results &results, uint32_t nowMillis);
+
+    // The timeout the receiver should be using right now.
+    uint8_t timeoutMs(uint32_t nowMillis) const;
+
+    uint8_t longTimeoutMs() const { return _longTimeoutMs; }
+    void setLongTimeoutMs(uint8_t longTimeoutMs) {
+        _longTimeoutMs = longTimeoutMs;
+    }
+
+private:
+    static const uint8_t kMaxProtocols = 8;
+
+    struct Learned {
+        int16_t  decodeType;
+        uint8_t  neededMs;   // Shortest timeout that keeps it in one piece
+        uint32_t lastSeen;   // millis()
+    };
+
+    uint8_t  _longTimeoutMs;
+    uint32_t _holdLongUntil;
+    bool     _holding;
+    Learned  _learned[kMaxProtocols];
+    uint8_t  _count;
+};
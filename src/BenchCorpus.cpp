@@ -0,0 +1,59 @@
+/*
+    BenchCorpus
+
+    See BenchCorpus.h.  Timings have the usual few us of receiver jitter in
+    them, it's the decoders' tolerance matching that's being timed too.
+*/
+#include "BenchCorpus.h"
+
+// Vizio (NEC) 0x20DF40BF
+static const uint16_t kBenchRaw0[67] PROGMEM = {
+    8966, 4522, 560, 564, 569, 560, 572, 1693, 562, 559, 569, 563, 557, 567,
+    569, 563, 564, 548, 564, 1692, 570, 1679, 549, 561, 565, 1682, 569, 1683,
+    564, 1687, 566, 1697, 551, 1687, 569, 567, 551, 1684, 555, 562, 550, 552,
+    554, 550, 549, 558, 559, 565, 548, 567, 552, 1684, 565, 548, 553, 1685,
+    562, 1697, 552, 1685, 571, 1691, 558, 1692, 565, 1679, 559
+};
+
+// Comcast XR2 "NOP", XMP 0x170F443E14008300
+static const uint16_t kBenchRaw1[35] PROGMEM = {
+    207, 888, 208, 1709, 214, 764, 202, 2783, 204, 1295, 218, 1305, 211, 1166,
+    204, 2655, 208, 13021, 211, 898, 208, 1303, 213, 754, 214, 757, 215, 1842,
+    206, 1167, 209, 752, 216, 768, 208
+};
+
+// Samsung 0xE0E040BF
+static const uint16_t kBenchRaw2[67] PROGMEM = {
+    4496, 4465, 568, 1692, 570, 1670, 556, 1671, 561, 567, 566, 571, 572, 569,
+    565, 553, 555, 572, 565, 1671, 571, 1676, 558, 1675, 565, 563, 558, 559,
+    563, 549, 557, 572, 563, 558, 557, 568, 564, 1691, 569, 548, 569, 558,
+    569, 549, 549, 549, 564, 557, 561, 556, 558, 1670, 556, 554, 572, 1686,
+    567, 1687, 568, 1672, 568, 1685, 557, 1681, 551, 1668, 570
+};
+
+// Not any protocol, ends up as an UNKNOWN hash
+static const uint16_t kBenchRaw3[37] PROGMEM = {
+    349, 124, 681, 389, 398, 348, 602, 774, 756, 398, 845, 377, 849, 894, 434,
+    140, 428, 253, 83, 889, 179, 588, 60, 501, 212, 618, 248, 198, 792, 733,
+    883, 365, 373, 722, 516, 785, 829
+};
+
+static const char kBenchName0[] PROGMEM = "Vizio NEC 0x20DF40BF";
+static const char kBenchName1[] PROGMEM = "Comcast XMP NOP";
+static const char kBenchName2[] PROGMEM = "Samsung 0xE0E040BF";
+static const char kBenchName3[] PROGMEM = "UNKNOWN noise";
+
+const BenchCapture kBenchCorpus[] PROGMEM = {
+    { kBenchName0, kBenchRaw0, sizeof(kBenchRaw0) / sizeof(kBenchRaw0[0]) },
+    { kBenchName1, kBenchRaw1, sizeof(kBenchRaw1) / sizeof(kBenchRaw1[0]) },
+    { kBenchName2, kBenchRaw2, sizeof(kBenchRaw2) / sizeof(kBenchRaw2[0]) },
+    { kBenchName3, kBenchRaw3, sizeof(kBenchRaw3) / sizeof(kBenchRaw3[0]) },
+};
+
+const uint8_t kBenchCorpusSize = sizeof(kBenchCorpus) / sizeof(kBenchCorpus[0]);
+
+BenchCapture benchCapture(uint8_t index) {
+    BenchCapture capture;
+    memcpy_P(&capture, &kBenchCorpus[index], sizeof(capture));
+    return capture;
+}
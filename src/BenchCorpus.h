@@ -0,0 +1,27 @@
+/*
+    BenchCorpus
+
+    Raw captures (in flash) for the benchmark build, see BENCHMARK_MODE in
+    Config.h.  Each one is a rawData[] array as printed by the
+    "[resultsToSourceCode]" output, in microseconds.
+
+    To add one, paste its rawData[] into BenchCorpus.cpp and add a line to
+    kBenchCorpus[].  A mix is good: every protocol compiled in is tried in
+    turn until one matches, so the ones decoded late in that order (and
+    UNKNOWN, which tries them all) are the slow ones.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+struct BenchCapture {
+    const char     *name;      // PROGMEM, ex. "Vizio NEC 0x20DF40BF"
+    const uint16_t *rawUsecs;  // PROGMEM
+    uint16_t        rawLen;
+};
+
+extern const BenchCapture kBenchCorpus[] PROGMEM;
+extern const uint8_t kBenchCorpusSize;
+
+// Copy entry index out of flash
+BenchCapture benchCapture(uint8_t index);
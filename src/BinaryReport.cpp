@@ -0,0 +1,176 @@
+/*
+    BinaryReport
+
+    See BinaryReport.h for the frame layout.
+
+    The length has to go in front of the payload, and there's no buffer big
+    enough to hold a long capture, so the payload is simply generated twice:
+    once into a FrameCounter to size it, then again for real through a
+    FrameCrc that keeps the running CRC as the bytes go by.
+*/
+#include "BinaryReport.h"
+#include <IRutils.h>
+#include "TextReport.h"
+#include "RawCodec.h"
+#include "Varint.h"
+
+uint16_t crc16Update(uint16_t crc, uint8_t data) {
+    crc ^= ((uint16_t)data << 8);
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+                             : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+// A Print that only counts what would have been written.
+class FrameCounter : public Print {
+public:
+    FrameCounter() : count(0) {}
+    size_t write(uint8_t) override {
+        count++;
+        return 1;
+    }
+    using Print::write;
+
+    size_t count;
+};
+
+// A Print that forwards to another one, keeping a CRC of everything.
+class FrameCrc : public Print {
+public:
+    explicit FrameCrc(Print &out) : crc(0xFFFF), _out(out) {}
+    size_t write(uint8_t c) override {
+        crc = crc16Update(crc, c);
+        return _out.write(c);
+    }
+    using Print::write;
+
+    uint16_t crc;
+
+private:
+    Print &_out;
+};
+
+static void writePayload(Print &out, const decode_results &results,
+                         const CaptureRecord &record) {
+    uint8_t flags = record.flags;
+    bool hasState = hasACState(results.decode_type);
+    if (hasState) {
+        flags |= kBinaryHasState;
+    }
+    if (record.source != kCaptureNoSource) {
+        flags |= kBinaryHasSource;
+    }
+    bool hasTiming = (record.times.endMicros != 0);
+    if (hasTiming) {
+        flags |= kBinaryHasTiming;
+    }
+    bool hasCarrier = (record.carrier.cycles != 0);
+    if (hasCarrier) {
+        flags |= kBinaryHasCarrier;
+    }
+
+    out.write(kBinaryVersion);
+    out.write(kBinaryRecordCapture);
+    out.write(flags);
+    writeVarint(out, (uint64_t)((int32_t)results.decode_type + 1));
+
+    // Protocol name, so the host doesn't need to know this library
+    // version's decode_type_t numbering.
+    FrameCounter nameLength;
+    printProtocolName(nameLength, results.decode_type);
+    out.write((uint8_t)nameLength.count);
+    printProtocolName(out, results.decode_type);
+
+    writeVarint(out, results.bits);
+    writeVarint(out, record.captureMillis);
+
+    if (record.source != kCaptureNoSource) {
+        out.write(record.source);
+    }
+
+    if (hasTiming) {
+        writeVarint(out, record.times.startMicros);
+        writeVarint(out, record.times.endMicros - record.times.startMicros);
+        writeVarint(out, record.times.gapMicros);
+    }
+
+    if (hasCarrier) {
+        writeVarint(out, record.carrier.frequencyHz);
+        out.write(record.carrier.dutyPercent);
+        writeVarint(out, record.carrier.cycles);
+    }
+
+    if (hasState) {
+        uint8_t nbytes = (uint8_t)min((uint16_t)((results.bits + 7) / 8),
+                                      kStateSizeMax);
+        out.write(nbytes);
+        out.write(results.state, nbytes);
+    } else {
+        writeVarint(out, results.value);
+        writeVarint(out, results.address);
+        writeVarint(out, results.command);
+    }
+
+    // Raw timings, skipping rawbuf[0] (the gap before the message) just
+    // like resultToSourceCode() does.
+    encodeRaw(out, results);
+}
+
+static void writeRepeatPayload(Print &out, const RepeatEntry &entry) {
+    decode_type_t decodeType = (decode_type_t)entry.decodeType;
+
+    out.write(kBinaryVersion);
+    out.write(kBinaryRecordRepeat);
+    out.write(hasACState(decodeType) ? kBinaryHasState : (uint8_t)0);
+    writeVarint(out, (uint64_t)((int32_t)entry.decodeType + 1));
+
+    FrameCounter nameLength;
+    printProtocolName(nameLength, decodeType);
+    out.write((uint8_t)nameLength.count);
+    printProtocolName(out, decodeType);
+
+    writeVarint(out, entry.bits);
+    writeVarint(out, entry.value);
+    writeVarint(out, entry.firstMillis);
+    writeVarint(out, entry.lastMillis - entry.firstMillis);
+    writeVarint(out, entry.hits);
+}
+
+/*
+writeFrame
+
+Sync, length, the payload from writer(), CRC.  writer() is called twice, see
+the top of this file.
+*/
+template<typename Writer>
+static void writeFrame(Print &out, Writer writer) {
+    FrameCounter sizing;
+    writer(sizing);
+    uint16_t length = (uint16_t)min(sizing.count, (size_t)UINT16_MAX);
+
+    out.write(kBinarySync0);
+    out.write(kBinarySync1);
+
+    FrameCrc framed(out);
+    framed.write((uint8_t)(length & 0xFF));
+    framed.write((uint8_t)(length >> 8));
+    writer(framed);
+
+    out.write((uint8_t)(framed.crc & 0xFF));
+    out.write((uint8_t)(framed.crc >> 8));
+}
+
+void printBinaryReport(Print &out, const decode_results &results,
+                       const CaptureRecord &record) {
+    writeFrame(out, [&](Print &payload) {
+        writePayload(payload, results, record);
+    });
+}
+
+void printBinaryRepeat(Print &out, const RepeatEntry &entry) {
+    writeFrame(out, [&](Print &payload) {
+        writeRepeatPayload(payload, entry);
+    });
+}
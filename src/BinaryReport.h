@@ -0,0 +1,89 @@
+/*
+    BinaryReport
+
+    A compact, CRC checked alternative to the text BEGIN/END blocks.  At
+    115200 baud the rawData[] text for one long capture can take longer to
+    send than the IR frame took to arrive; this framing is typically 5-10x
+    smaller, mostly because the raw timings are sent as small deltas.
+    Version 2 sends them with RawCodec (quantized, with runs of repeats);
+    version 1 sent every tick.
+
+    Frame:
+        0xA5 0x5A           Sync
+        uint16 (LE)         Payload length
+        payload
+        uint16 (LE)         CRC-16/CCITT-FALSE of the length + payload
+
+    Payload (varint = LEB128, zvarint = zigzag LEB128):
+        uint8               Version (kBinaryVersion)
+        uint8               Record type (kBinaryRecordCapture)
+        uint8               Flags (kCapture* from CaptureQueue.h, plus
+                            kBinaryHasState for A/C protocols,
+                            kBinaryHasSource with several receivers and
+                            kBinaryHasTiming with FRAME_TIMING and
+                            kBinaryHasCarrier with CARRIER_METER)
+        varint              decode_type + 1 (so UNKNOWN is 0)
+        uint8 + chars       Protocol name, ex. "NEC" (length prefixed)
+        varint              Bits
+        varint              captureMillis
+        kBinaryHasSource:   uint8 GPIO of the receiver it came from
+        kBinaryHasTiming:   varint micros() of the frame's first edge,
+                            varint frame length in us (first to last edge),
+                            varint gap in us since the frame before (0 if
+                            none)
+        kBinaryHasCarrier:  varint carrier frequency in Hz, uint8 duty
+                            cycle %, varint carrier periods measured
+        kBinaryHasState:    uint8 byte count, then the state[] bytes
+        otherwise:          varint value, varint address, varint command
+        bytes               Raw timings (rawlen - 1 of them, no leading
+                            gap), encoded by RawCodec (see RawCodec.h)
+
+    Repeat summary payload (kBinaryRecordRepeat, see RepeatCache.h):
+        uint8               Version
+        uint8               Record type (kBinaryRecordRepeat)
+        uint8               Flags (kBinaryHasState: value is always 0)
+        varint              decode_type + 1
+        uint8 + chars       Protocol name
+        varint              Bits
+        varint              Value
+        varint              millis the code was first seen
+        varint              ms from then to when it was last seen
+        varint              Hits (times it was seen again, not sent)
+
+    Anything between frames (ex. the text printed at boot) is ignored by the
+    host side decoder, tools/irrecord_binary.py, which just hunts for the
+    next sync + valid CRC.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#include "CaptureQueue.h"
+#include "RepeatCache.h"
+
+const uint8_t kBinarySync0         = 0xA5;
+const uint8_t kBinarySync1         = 0x5A;
+const uint8_t kBinaryVersion       = 2;
+const uint8_t kBinaryRecordCapture = 1;
+const uint8_t kBinaryRecordRepeat  = 2;
+
+// Payload flag: state[] is sent instead of value/address/command
+const uint8_t kBinaryHasState      = 0x80;
+// Payload flag: the receiver's GPIO follows captureMillis
+const uint8_t kBinaryHasSource     = 0x40;
+// Payload flag: the frame's FrameTimes follow the source
+const uint8_t kBinaryHasTiming     = 0x20;
+// Payload flag: the frame's CarrierReading follows the times
+const uint8_t kBinaryHasCarrier    = 0x10;
+
+// Write one queued capture (results from CaptureQueue::toResults()) as a
+// binary frame.  The source, times and carrier are left out if the record
+// has none.
+void printBinaryReport(Print &out, const decode_results &results,
+                       const CaptureRecord &record);
+
+// Write a RepeatCache summary as a binary frame.
+void printBinaryRepeat(Print &out, const RepeatEntry &entry);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), one byte at a time
+uint16_t crc16Update(uint16_t crc, uint8_t data);
@@ -0,0 +1,122 @@
+/*
+    CaptureQueue
+
+    See CaptureQueue.h.  The raw pool works like the record ring but in
+    words: _rawHead/_rawTail run freely and are masked when used.  A block of
+    timings is always kept contiguous (so it can be handed to the library as
+    a normal rawbuf pointer); if it won't fit before the end of the pool, the
+    leftover words at the end are skipped and it starts again at index 0.
+    Those skipped words are given back when the record after them is popped.
+*/
+#include "CaptureQueue.h"
+
+const uint32_t kRawPoolMask = (CAPTURE_RAW_POOL_WORDS - 1);
+
+CaptureQueue::CaptureQueue()
+    : _rawHead(0), _rawTail(0), _highWater(0), _drops(0) {
+}
+
+bool CaptureQueue::push(const decode_results &results,
+                        uint32_t captureMillis, uint8_t timeoutMs,
+                        uint32_t decodeMicros, uint8_t source,
+                        const FrameTimes *times,
+                        const CarrierReading *carrier) {
+    CaptureRecord *record = _records.reserve();
+    if (record == NULL) {
+        _drops++;
+        return false;
+    }
+
+    uint8_t flags = 0;
+    if (results.overflow) {
+        flags |= kCaptureOverflow;
+    }
+    if (results.repeat) {
+        flags |= kCaptureRepeat;
+    }
+
+    uint16_t rawLen = results.rawlen;
+    if (rawLen > CAPTURE_RAW_POOL_WORDS) {
+        rawLen = CAPTURE_RAW_POOL_WORDS;
+        flags |= kCaptureRawTruncated;
+    }
+
+    // Skip to the start of the pool if this block won't fit before the end
+    uint32_t start  = _rawHead;
+    uint32_t offset = (start & kRawPoolMask);
+    if ((offset + rawLen) > CAPTURE_RAW_POOL_WORDS) {
+        start += (CAPTURE_RAW_POOL_WORDS - offset);
+        offset = 0;
+    }
+
+    if (((start + rawLen) - _rawTail) > CAPTURE_RAW_POOL_WORDS) {
+        _drops++; // Not enough raw space left until the output side catches up
+        return false;
+    }
+
+    for (uint16_t i = 0; i < rawLen; i++) {
+        _raw[offset + i] = results.rawbuf[i];
+    }
+
+    record->captureMillis = captureMillis;
+    record->decodeMicros  = decodeMicros;
+    memcpy(record->state, results.state, sizeof(record->state));
+    record->decodeType = (int16_t)results.decode_type;
+    record->bits       = results.bits;
+    record->rawStart   = start;
+    record->rawLen     = rawLen;
+    record->flags      = flags;
+    record->timeoutMs  = timeoutMs;
+    record->source     = source;
+    if (times != NULL) {
+        record->times = *times;
+    } else {
+        memset(&record->times, 0, sizeof(record->times));
+    }
+    if (carrier != NULL) {
+        record->carrier = *carrier;
+    } else {
+        memset(&record->carrier, 0, sizeof(record->carrier));
+    }
+
+    _rawHead = (start + rawLen);
+    _records.commit();
+
+    if (_records.size() > _highWater) {
+        _highWater = _records.size();
+    }
+    return true;
+}
+
+const CaptureRecord *CaptureQueue::front() const {
+    return _records.peek();
+}
+
+const CaptureRecord *CaptureQueue::at(uint16_t index) const {
+    return _records.peek(index);
+}
+
+const uint16_t *CaptureQueue::rawData(const CaptureRecord &record) const {
+    return &_raw[record.rawStart & kRawPoolMask];
+}
+
+void CaptureQueue::toResults(const CaptureRecord &record,
+                             decode_results *results) const {
+    results->decode_type = (decode_type_t)record.decodeType;
+    memcpy(results->state, record.state, sizeof(results->state));
+    results->bits     = record.bits;
+    results->rawbuf   = const_cast<uint16_t *>(rawData(record));
+    results->rawlen   = record.rawLen;
+    results->overflow = (record.flags & kCaptureOverflow) != 0;
+    results->repeat   = (record.flags & kCaptureRepeat) != 0;
+}
+
+void CaptureQueue::pop() {
+    const CaptureRecord *record = _records.peek();
+    if (record == NULL) {
+        return;
+    }
+
+    _rawTail = (record->rawStart + record->rawLen);
+    _records.release();
+}
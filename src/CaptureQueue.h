@@ -0,0 +1,133 @@
+/*
+    CaptureQueue
+
+    Decouples capturing IR codes from outputting them.  loop() pushes each
+    decoded result in here as soon as IRrecv::decode() returns it, and the
+    (slow) Serial/OLED output drains it at its own pace.  That way a burst of
+    codes (ex. the XR2 "All Power" button sending NEC+XMP+XMP) isn't lost while
+    the first one is still being printed.
+
+    Each entry is a compact CaptureRecord (the decoded fields only).  The raw
+    timings are copied into one shared pool of uint16_t words, handed out in
+    the same FIFO order as the records, so a queue full of short NEC codes
+    doesn't need a 4096 entry buffer per record.
+
+    Only one producer (the capture side) and one consumer (the output side)
+    are supported, the same as SpscRing.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#include "Config.h"
+#include "SpscRing.h"
+
+// How many decoded codes can be waiting to be output.  Power of two.
+#ifndef CAPTURE_QUEUE_DEPTH
+#define CAPTURE_QUEUE_DEPTH      8
+#endif
+
+// CAPTURE_RAW_POOL_WORDS (the size of the pool of raw timings shared by all
+// queued codes, a power of two) comes from the profile in Config.h.
+
+// CaptureRecord::flags
+const uint8_t kCaptureOverflow     = 0x01; // IRrecv's capture buffer was full
+const uint8_t kCaptureRepeat       = 0x02; // Decoder flagged a repeat code
+const uint8_t kCaptureRawTruncated = 0x04; // Raw timings didn't fit the pool
+
+// CaptureRecord::source when there's only the one receiver
+const uint8_t kCaptureNoSource     = 0xFF;
+
+// When a frame happened, FRAME_TIMING only (see Config.h), all 0 otherwise
+struct FrameTimes {
+    uint32_t startMicros;   // micros() of the frame's first edge
+    uint32_t endMicros;     // micros() of its last edge
+    uint32_t gapMicros;     // Since the end of the frame before it, 0 if none
+};
+
+// The frame's carrier, CARRIER_METER only (see CarrierMeter.h), all 0
+// otherwise or if none was seen
+struct CarrierReading {
+    uint32_t frequencyHz;   // Average over the frame
+    uint16_t cycles;        // Carrier periods it was measured over
+    uint8_t  dutyPercent;   // Of each period the carrier was on
+};
+
+struct CaptureRecord {
+    uint32_t captureMillis; // millis() when decode() returned it
+    uint32_t decodeMicros;  // How long the successful decode() call took
+
+    // Same layout as decode_results, A/C protocols use state[] instead
+    union {
+        struct {
+            uint64_t value;
+            uint32_t address;
+            uint32_t command;
+        };
+        uint8_t state[kStateSizeMax];
+    };
+
+    int16_t  decodeType;    // decode_type_t
+    uint16_t bits;
+    uint32_t rawStart;      // Where the raw timings begin in the pool
+    uint16_t rawLen;        // Same as decode_results::rawlen
+    uint8_t  flags;         // kCapture* flags above
+    uint8_t  timeoutMs;     // Receiver timeout it was captured with
+    uint8_t  source;        // GPIO of the receiver it came from, see above
+    FrameTimes times;
+    CarrierReading carrier;
+};
+
+class CaptureQueue {
+    static_assert((CAPTURE_RAW_POOL_WORDS &
+                   (CAPTURE_RAW_POOL_WORDS - 1)) == 0,
+                  "CAPTURE_RAW_POOL_WORDS must be a power of two");
+
+public:
+    CaptureQueue();
+
+    // -- Producer side --
+
+    // Copy the decoded fields and raw timings.  Returns false (and counts a
+    // drop) if there is no room for either.
+    bool push(const decode_results &results, uint32_t captureMillis,
+              uint8_t timeoutMs = 0, uint32_t decodeMicros = 0,
+              uint8_t source = kCaptureNoSource,
+              const FrameTimes *times = NULL,
+              const CarrierReading *carrier = NULL);
+
+    // -- Consumer side --
+
+    // Oldest record, or NULL if empty.  Stays valid until pop().
+    const CaptureRecord *front() const;
+
+    // The record index places behind front() (0 is front()), or NULL if
+    // there aren't that many.  Also valid until it's popped.
+    const CaptureRecord *at(uint16_t index) const;
+
+    // Raw timings for a queued record (rawLen entries, IRrecv ticks).
+    const uint16_t *rawData(const CaptureRecord &record) const;
+
+    // Fill in a decode_results that points at a queued record, so the
+    // IRremoteESP8266 helpers (resultToSourceCode() etc.) can be used on it.
+    void toResults(const CaptureRecord &record, decode_results *results) const;
+
+    // Done with front(), give its slot and raw timings back.
+    void pop();
+
+    // -- Stats --
+
+    uint16_t size() const { return _records.size(); }
+    uint16_t highWater() const { return _highWater; }
+    uint32_t drops() const { return _drops; }
+
+private:
+    SpscRing<CaptureRecord, CAPTURE_QUEUE_DEPTH> _records;
+
+    uint16_t _raw[CAPTURE_RAW_POOL_WORDS];
+    volatile uint32_t _rawHead; // Words handed out (producer), free running
+    volatile uint32_t _rawTail; // Words given back (consumer), free running
+
+    uint16_t _highWater;        // Most records ever waiting at once
+    uint32_t _drops;            // Codes lost because the queue was full
+};
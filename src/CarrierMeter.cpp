@@ -0,0 +1,84 @@
+/*
+    CarrierMeter
+
+    See CarrierMeter.h
+*/
+#include "CarrierMeter.h"
+
+CarrierMeter::CarrierMeter()
+    : _pin(0), _maxPeriodCycles(0), _lastOnCycles(0), _periodCycles(0),
+      _onCycles(0), _periods(0), _ons(0), _frames(0), _empty(0) {
+}
+
+bool CarrierMeter::begin(uint8_t pin) {
+    _pin = pin;
+    _maxPeriodCycles = (ESP.getCpuFreqMHz() * 1000000UL) / CARRIER_MIN_HZ;
+
+    pinMode(_pin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(_pin), onEdge, this, CHANGE);
+    return true;
+}
+
+void IRAM_ATTR CarrierMeter::onEdge(void *arg) {
+    CarrierMeter &meter = *(CarrierMeter *)arg;
+    uint32_t now   = ESP.getCycleCount();
+    uint32_t since = now - meter._lastOnCycles;
+
+    // Once a count is full, the totals are left alone until take()
+    if (digitalRead(meter._pin) == CARRIER_ACTIVE_LEVEL) {
+        if ((since <= meter._maxPeriodCycles) &&
+            (meter._periods < UINT16_MAX)) {
+            meter._periodCycles += since;
+            meter._periods++;
+        }
+        meter._lastOnCycles = now;
+    } else if ((since <= meter._maxPeriodCycles) &&
+               (meter._ons < UINT16_MAX)) {
+        meter._onCycles += since;
+        meter._ons++;
+    }
+}
+
+bool CarrierMeter::take(CarrierReading *reading) {
+    noInterrupts();
+    uint32_t periodCycles = _periodCycles;
+    uint32_t onCycles     = _onCycles;
+    uint16_t periods      = _periods;
+    uint16_t ons          = _ons;
+    _periodCycles = 0;
+    _onCycles     = 0;
+    _periods      = 0;
+    _ons          = 0;
+    interrupts();
+
+    if (reading == NULL) {
+        return (periods > 0);
+    }
+
+    if ((periods == 0) || (ons == 0) || (periodCycles == 0)) {
+        memset(reading, 0, sizeof(*reading));
+        _empty++;
+        return false;
+    }
+
+    // Average on time over average period, both in cycles
+    uint64_t cyclesPerSecond = ESP.getCpuFreqMHz() * 1000000ULL;
+    uint64_t duty = ((uint64_t)onCycles * periods * 100) /
+                    ((uint64_t)periodCycles * ons);
+
+    reading->frequencyHz = (uint32_t)((cyclesPerSecond * periods) /
+                                      periodCycles);
+    reading->cycles      = periods;
+    reading->dutyPercent = (uint8_t)min(duty, (uint64_t)100);
+    _frames++;
+    return true;
+}
+
+void CarrierMeter::print(Print &out) const {
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[64];
+    snprintf(line, sizeof(line), "[Carrier] %u frames, %u with no carrier\n",
+             (unsigned)(_frames + _empty),
+             (unsigned)_empty);
+    out.print(line);
+}
@@ -0,0 +1,80 @@
+/*
+    CarrierMeter
+
+    The TSOP receiver only gives the envelope of a frame: its output is the
+    carrier already taken away, so there's no telling whether a sender's
+    carrier is really 38 kHz (or 36, 40, 56, ...), or what its duty cycle is.
+
+    This measures it from a second sensor on CARRIER_PIN that passes the
+    carrier straight through, ex. a TSMP58000 or an IR photodiode /
+    phototransistor into a comparator, pointed the same way as the TSOP.
+    Every edge of the carrier interrupts, and the ISR times it with the CPU
+    cycle counter, but doesn't store the edges: a 38 kHz carrier is ~76000
+    edges a second, ~1000x what the TSOP gives, and a long A/C frame would
+    need tens of KB.  Instead it only adds to a few running totals, so it's
+    the same few bytes whatever the frame length:
+        - the length of every carrier period (on edge to on edge), and
+        - how long the carrier was on in each one (on edge to off edge)
+    Anything longer than a period at CARRIER_MIN_HZ is the gap between
+    bursts (a space), not the carrier, and isn't counted.
+
+    take() gives what was measured since the last take(), as the average
+    frequency and duty cycle, and starts again.  It's called as each frame
+    from the TSOP is decoded, which is a receiver timeout after the frame's
+    last burst, so it's the carrier of that frame.  Frames that aren't
+    decoded (ex. noise RawFilter dropped) are taken too, and thrown away.
+
+    The ISR is short, but at 76000 a second it's still a good part of the
+    CPU during a frame, and it can hold up the TSOP's own edge interrupt by
+    a few us.  That's why it's off unless CARRIER_METER is set.  The duty
+    cycle is what the sensor gives: a slow photodiode stretches or shrinks
+    the on time, so compare readings from the same sensor.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "CaptureQueue.h"
+
+// Lowest carrier that's measured (Hz).  An on edge later than one period of
+// this after the last is the start of a new burst.
+#ifndef CARRIER_MIN_HZ
+#define CARRIER_MIN_HZ        20000
+#endif
+
+// Level of CARRIER_PIN while the carrier is on (most sensor modules pull
+// low, so LOW)
+#ifndef CARRIER_ACTIVE_LEVEL
+#define CARRIER_ACTIVE_LEVEL  LOW
+#endif
+
+class CarrierMeter {
+public:
+    CarrierMeter();
+
+    bool begin(uint8_t pin);
+
+    // Everything since the last take(), and start again.  Returns false
+    // (reading all 0) if there was no carrier at all.  reading can be NULL
+    // to just throw it away.
+    bool take(CarrierReading *reading);
+
+    // Of the readings taken (not thrown away), ex.
+    // "[Carrier] 48 frames, 2 with no carrier"
+    void print(Print &out) const;
+
+private:
+    static void IRAM_ATTR onEdge(void *arg);
+
+    uint8_t  _pin;
+    uint32_t _maxPeriodCycles;      // One period at CARRIER_MIN_HZ
+
+    // Written by the ISR, read and cleared by take()
+    volatile uint32_t _lastOnCycles;
+    volatile uint32_t _periodCycles;  // Sum of every period's length
+    volatile uint32_t _onCycles;      // Sum of every on time
+    volatile uint16_t _periods;
+    volatile uint16_t _ons;
+
+    uint32_t _frames;               // take()s with a carrier
+    uint32_t _empty;                // take()s without
+};
@@ -0,0 +1,489 @@
+/*
+    CodeLibrary
+
+    See CodeLibrary.h.  Records and index entries are written as the raw
+    structs (the files never leave this device), and the record number
+    times sizeof(CodeRecord) is its offset in /codes.dat.
+*/
+#include "CodeLibrary.h"
+#include <LittleFS.h>
+#include <IRutils.h>
+#include "TextReport.h"
+#include "RawCodec.h"
+
+static const char kCodesPath[]    = "/codes.dat";
+static const char kIndexPath[]    = "/codes.idx";
+static const char kIndexTmpPath[] = "/codes.idx.tmp";
+static const char kRawPath[]      = "/codes.raw";
+static const char kLabelsPath[]   = "/labels.csv";
+
+// Index entries copied per read/write when inserting
+const uint8_t kIndexCopyEntries = 16;
+
+static int compareKey(int16_t typeA, uint64_t valueA,
+                      int16_t typeB, uint64_t valueB) {
+    if (typeA != typeB) {
+        return (typeA < typeB) ? -1 : 1;
+    }
+    if (valueA != valueB) {
+        return (valueA < valueB) ? -1 : 1;
+    }
+    return 0;
+}
+
+// A Print that only counts, to size an encoded capture before writing it
+class ByteCounter : public Print {
+public:
+    ByteCounter() : count(0) {}
+    size_t write(uint8_t) override {
+        count++;
+        return 1;
+    }
+    using Print::write;
+
+    size_t count;
+};
+
+CodeLibrary::CodeLibrary() : _ready(false), _count(0), _rawSize(0) {
+}
+
+bool CodeLibrary::isLibraryCode(decode_type_t decodeType) {
+    return (decodeType != UNKNOWN) && !hasACState(decodeType);
+}
+
+bool CodeLibrary::begin() {
+    _ready = LittleFS.begin();
+    if (!_ready) {
+        return false;
+    }
+
+    // Power cut in the middle of swapping in a new index
+    if (!LittleFS.exists(kIndexPath) && LittleFS.exists(kIndexTmpPath)) {
+        LittleFS.rename(kIndexTmpPath, kIndexPath);
+    }
+
+    File index = LittleFS.open(kIndexPath, "r");
+    _count = index ? (index.size() / sizeof(CodeIndexEntry)) : 0;
+    index.close();
+
+    _rawSize = scanRaw();
+
+    if (LittleFS.exists(kLabelsPath)) {
+        importLabels(kLabelsPath);
+    }
+    return true;
+}
+
+bool CodeLibrary::find(int16_t decodeType, uint64_t value, uint32_t *position,
+                       CodeIndexEntry *entry) {
+    *position = 0;
+    if (_count == 0) {
+        return false;
+    }
+
+    File index = LittleFS.open(kIndexPath, "r");
+    if (!index) {
+        return false;
+    }
+
+    uint32_t low  = 0;
+    uint32_t high = _count;
+    bool found    = false;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+
+        CodeIndexEntry probe;
+        index.seek(middle * sizeof(probe), SeekSet);
+        if ((size_t)index.read((uint8_t *)&probe, sizeof(probe)) !=
+            sizeof(probe)) {
+            break;
+        }
+
+        int order = compareKey(decodeType, value,
+                               probe.decodeType, probe.value);
+        if (order == 0) {
+            *entry = probe;
+            low    = middle;
+            found  = true;
+            break;
+        }
+        if (order < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    index.close();
+    *position = low;
+    return found;
+}
+
+bool CodeLibrary::readRecord(uint32_t number, CodeRecord *record) {
+    File codes = LittleFS.open(kCodesPath, "r");
+    if (!codes) {
+        return false;
+    }
+
+    bool ok = codes.seek(number * sizeof(CodeRecord), SeekSet) &&
+              ((size_t)codes.read((uint8_t *)record, sizeof(CodeRecord)) ==
+               sizeof(CodeRecord));
+    codes.close();
+
+    record->label[kCodeLabelSize - 1] = '\0';
+    return ok;
+}
+
+bool CodeLibrary::appendRecord(const CodeRecord &record, uint32_t *number) {
+    File codes = LittleFS.open(kCodesPath, "r+");
+    if (!codes) {
+        codes = LittleFS.open(kCodesPath, "w");
+    }
+    if (!codes) {
+        return false;
+    }
+
+    // A short write (full filesystem) could have left part of a record at
+    // the end, so write over it rather than after it.
+    *number = codes.size() / sizeof(CodeRecord);
+    codes.seek(*number * sizeof(CodeRecord), SeekSet);
+    bool ok = (codes.write((const uint8_t *)&record, sizeof(record)) ==
+               sizeof(record));
+    codes.close();
+    return ok;
+}
+
+uint32_t CodeLibrary::scanRaw() {
+    File raw = LittleFS.open(kRawPath, "r");
+    if (!raw) {
+        return 0;
+    }
+
+    // Header to header, stopping at one that was cut short
+    uint32_t size = raw.size();
+    uint32_t end  = 0;
+    CodeRawHeader header;
+    while ((end + sizeof(header)) <= size) {
+        raw.seek(end, SeekSet);
+        if (((size_t)raw.read((uint8_t *)&header, sizeof(header)) !=
+             sizeof(header)) ||
+            ((end + sizeof(header) + header.bytes) > size)) {
+            break;
+        }
+        end += sizeof(header) + header.bytes;
+    }
+    raw.close();
+    return end;
+}
+
+bool CodeLibrary::appendRaw(const decode_results &results) {
+    ByteCounter sizing;
+    encodeRaw(sizing, results);
+    if ((results.rawlen < 2) || (sizing.count > kCodeRawMaxBytes)) {
+        return false;
+    }
+
+    File raw = LittleFS.open(kRawPath, "r+");
+    if (!raw) {
+        raw = LittleFS.open(kRawPath, "w");
+    }
+    if (!raw) {
+        return false;
+    }
+
+    CodeRawHeader header;
+    memset(&header, 0, sizeof(header));
+    header.value      = results.value;
+    header.decodeType = (int16_t)results.decode_type;
+    header.bytes      = (uint16_t)sizing.count;
+
+    // Same as appendRecord(), over anything left by a short write
+    raw.seek(_rawSize, SeekSet);
+    bool ok = (raw.write((const uint8_t *)&header, sizeof(header)) ==
+               sizeof(header)) &&
+              (encodeRaw(raw, results) == sizing.count);
+    raw.close();
+
+    if (ok) {
+        _rawSize += sizeof(header) + header.bytes;
+    }
+    return ok;
+}
+
+uint16_t CodeLibrary::loadRaw(decode_type_t decodeType, uint64_t value,
+                              uint16_t *rawUsecs, uint16_t maxEntries) {
+    if (!_ready) {
+        return 0;
+    }
+
+    File raw = LittleFS.open(kRawPath, "r");
+    if (!raw) {
+        return 0;
+    }
+
+    uint16_t count = 0;
+    uint32_t offset = 0;
+    CodeRawHeader header;
+    while ((offset + sizeof(header)) <= _rawSize) {
+        raw.seek(offset, SeekSet);
+        if ((size_t)raw.read((uint8_t *)&header, sizeof(header)) !=
+            sizeof(header)) {
+            break;
+        }
+        offset += sizeof(header) + header.bytes;
+
+        if ((header.decodeType != (int16_t)decodeType) ||
+            (header.value != value) || (header.bytes > kCodeRawMaxBytes)) {
+            continue;
+        }
+
+        uint8_t blob[kCodeRawMaxBytes];
+        if ((size_t)raw.read(blob, header.bytes) == header.bytes) {
+            count = decodeRaw(blob, header.bytes, rawUsecs, maxEntries);
+        }
+        break;
+    }
+
+    raw.close();
+    return count;
+}
+
+bool CodeLibrary::updateIndex(int16_t decodeType, uint64_t value,
+                              uint32_t record, uint32_t position,
+                              bool exists) {
+    CodeIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.value      = value;
+    entry.decodeType = decodeType;
+    entry.record     = record;
+
+    if (exists) {
+        // Same key, just point it at the newer record
+        File index = LittleFS.open(kIndexPath, "r+");
+        if (!index) {
+            return false;
+        }
+        index.seek(position * sizeof(entry), SeekSet);
+        bool ok = (index.write((const uint8_t *)&entry, sizeof(entry)) ==
+                   sizeof(entry));
+        index.close();
+        return ok;
+    }
+
+    // Insert: copy to a new file with the entry in its place, then swap.
+    File from = LittleFS.open(kIndexPath, "r");
+    File to   = LittleFS.open(kIndexTmpPath, "w");
+    if (!to) {
+        from.close();
+        return false;
+    }
+
+    CodeIndexEntry chunk[kIndexCopyEntries];
+    bool ok = true;
+    for (uint32_t done = 0; ok && (done < _count); ) {
+        if (done == position) {
+            ok = (to.write((const uint8_t *)&entry, sizeof(entry)) ==
+                  sizeof(entry));
+        }
+
+        // Up to the insert position, then the rest
+        uint32_t until = (done < position) ? position : _count;
+        uint32_t count = min((uint32_t)kIndexCopyEntries, until - done);
+        size_t   bytes = count * sizeof(CodeIndexEntry);
+
+        ok = ok && from &&
+             ((size_t)from.read((uint8_t *)chunk, bytes) == bytes) &&
+             (to.write((const uint8_t *)chunk, bytes) == bytes);
+        done += count;
+    }
+    if (ok && (position == _count)) {
+        ok = (to.write((const uint8_t *)&entry, sizeof(entry)) ==
+              sizeof(entry));
+    }
+
+    from.close();
+    to.close();
+
+    if (!ok) {
+        LittleFS.remove(kIndexTmpPath);
+        return false;
+    }
+
+    LittleFS.remove(kIndexPath);
+    LittleFS.rename(kIndexTmpPath, kIndexPath);
+    _count++;
+    return true;
+}
+
+bool CodeLibrary::lookup(decode_type_t decodeType, uint64_t value,
+                         CodeRecord *record) {
+    if (!_ready) {
+        return false;
+    }
+
+    uint32_t position;
+    CodeIndexEntry entry;
+    if (!find((int16_t)decodeType, value, &position, &entry)) {
+        return false;
+    }
+    return readRecord(entry.record, record);
+}
+
+bool CodeLibrary::add(const decode_results &results) {
+    if (!_ready || !isLibraryCode(results.decode_type)) {
+        return false;
+    }
+
+    uint32_t position;
+    CodeIndexEntry entry;
+    if (find((int16_t)results.decode_type, results.value, &position,
+             &entry)) {
+        return false;  // Already known
+    }
+
+    CodeRecord record;
+    memset(&record, 0, sizeof(record));
+    record.value      = results.value;
+    record.decodeType = (int16_t)results.decode_type;
+    record.bits       = results.bits;
+
+    uint32_t number;
+    if (!appendRecord(record, &number) ||
+        !updateIndex(record.decodeType, record.value, number, position,
+                     false)) {
+        return false;
+    }
+
+    // Only once it's in the index, so a code never has two
+    appendRaw(results);
+    return true;
+}
+
+bool CodeLibrary::setLabel(decode_type_t decodeType, uint64_t value,
+                           uint16_t bits, const char *label) {
+    if (!_ready || !isLibraryCode(decodeType)) {
+        return false;
+    }
+
+    CodeRecord record;
+    memset(&record, 0, sizeof(record));
+
+    uint32_t position;
+    CodeIndexEntry entry;
+    bool exists = find((int16_t)decodeType, value, &position, &entry);
+    if (exists && readRecord(entry.record, &record)) {
+        if ((strncmp(record.label, label, kCodeLabelSize - 1) == 0) &&
+            ((bits == 0) || (bits == record.bits))) {
+            return false;  // Nothing new
+        }
+    }
+
+    record.value      = value;
+    record.decodeType = (int16_t)decodeType;
+    if (bits) {
+        record.bits = bits;
+    }
+    strncpy(record.label, label, kCodeLabelSize - 1);
+    record.label[kCodeLabelSize - 1] = '\0';
+
+    uint32_t number;
+    return appendRecord(record, &number) &&
+           updateIndex(record.decodeType, value, number, position, exists);
+}
+
+uint16_t CodeLibrary::importLabels(const char *path) {
+    File csv = LittleFS.open(path, "r");
+    if (!csv) {
+        return 0;
+    }
+
+    uint16_t changed = 0;
+    char line[80];
+    while (csv.available()) {
+        // One line, anything past the end of line[] is dropped
+        size_t length = 0;
+        int c;
+        while (((c = csv.read()) >= 0) && (c != '\n')) {
+            if ((c != '\r') && (length < (sizeof(line) - 1))) {
+                line[length++] = (char)c;
+            }
+        }
+        line[length] = '\0';
+
+        // protocol,value,bits,label
+        char *fields[4] = {line, NULL, NULL, NULL};
+        for (uint8_t i = 1; i < 4; i++) {
+            char *comma = strchr(fields[i - 1], ',');
+            if (comma == NULL) {
+                break;
+            }
+            *comma    = '\0';
+            fields[i] = comma + 1;
+        }
+        if (fields[3] == NULL) {
+            continue;
+        }
+
+        decode_type_t decodeType = strToDecodeType(fields[0]);
+        if (!isLibraryCode(decodeType)) {
+            continue;  // Includes the header line
+        }
+
+        uint64_t value = strtoull(fields[1], NULL, 0);
+        uint16_t bits  = (uint16_t)strtoul(fields[2], NULL, 0);
+        if (setLabel(decodeType, value, bits, fields[3])) {
+            changed++;
+        }
+    }
+
+    csv.close();
+    return changed;
+}
+
+uint32_t CodeLibrary::exportCsv(Print &out) {
+    out.println(F("protocol,value,bits,label"));
+    if (!_ready || (_count == 0)) {
+        return 0;
+    }
+
+    File index = LittleFS.open(kIndexPath, "r");
+    File codes = LittleFS.open(kCodesPath, "r");
+    if (!index || !codes) {
+        return 0;
+    }
+
+    // Straight through the index in big reads, records are looked up as
+    // they come.
+    CodeIndexEntry chunk[kIndexCopyEntries];
+    uint32_t exported = 0;
+    for (uint32_t done = 0; done < _count; ) {
+        uint32_t count = min((uint32_t)kIndexCopyEntries, _count - done);
+        size_t   bytes = count * sizeof(CodeIndexEntry);
+        if ((size_t)index.read((uint8_t *)chunk, bytes) != bytes) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            CodeRecord record;
+            codes.seek(chunk[i].record * sizeof(record), SeekSet);
+            if ((size_t)codes.read((uint8_t *)&record, sizeof(record)) !=
+                sizeof(record)) {
+                continue;
+            }
+            record.label[kCodeLabelSize - 1] = '\0';
+
+            // Ex. "NEC,0x20DF40BF,32,Vizio Vol+"
+            printProtocolName(out, (decode_type_t)record.decodeType);
+            out.print(F(",0x"));
+            printUint64(out, record.value, 16);
+            out.printf(",%u,", (unsigned)record.bits);
+            out.println(record.label);
+            exported++;
+        }
+        done += count;
+    }
+
+    index.close();
+    codes.close();
+    return exported;
+}
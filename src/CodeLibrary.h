@@ -0,0 +1,131 @@
+/*
+    CodeLibrary
+
+    A library of every code this receiver has seen, kept in LittleFS so it
+    survives a reboot, with an optional label for each one (ex. "Vizio
+    Vol+") that displayResults() shows under the code.
+
+    Three files:
+
+    /codes.dat   Append-only CodeRecords, one per new code or label change.
+                 Nothing is ever rewritten, so a power cut can only lose the
+                 record being written.
+    /codes.idx   CodeIndexEntry for each distinct (decode_type, value),
+                 sorted, pointing at that code's latest record.  A lookup is
+                 a binary search of it: log2(n) small reads, no RAM needed.
+    /codes.raw   The raw timings of the first capture of each code, RawCodec
+                 encoded (see RawCodec.h), each behind a CodeRawHeader.
+                 Append-only like /codes.dat.  loadRaw() gets them back as
+                 rawData[] style microseconds, ex. for replayDecode() or to
+                 send the code again.
+
+    Labels come from /labels.csv (upload it with "pio run -t uploadfs" from
+    the data/ folder), one per line:
+        protocol,value,bits,label
+        NEC,0x20DF40BF,32,Vizio Vol+
+        XMP,0x170F443E14008300,,XR2 NOP
+    (bits can be left empty, and lines with an unknown protocol, like that
+    header, are skipped).  They're merged in by begin(); a label that's
+    already there isn't written again, so leaving the file in place is fine.
+
+    exportCsv() sends the whole table in that same layout, so it can go
+    straight into a spreadsheet, and back in as /labels.csv.
+
+    Only protocols with a value are kept; A/C (state[]) protocols and
+    UNKNOWN hashes aren't, as their 'value' doesn't identify a button.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+const uint8_t kCodeLabelSize = 20;  // Including the '\0'
+
+// One record in /codes.dat.  32 bytes.
+struct CodeRecord {
+    uint64_t value;
+    int16_t  decodeType;
+    uint16_t bits;
+    char     label[kCodeLabelSize];
+};
+
+// In front of each encoded capture in /codes.raw.  12 bytes.
+struct CodeRawHeader {
+    uint64_t value;
+    int16_t  decodeType;
+    uint16_t bytes;      // Encoded bytes that follow
+};
+
+// Encoded captures bigger than this aren't kept (a TV code is ~40 bytes)
+const uint16_t kCodeRawMaxBytes = 256;
+
+// One entry in /codes.idx, sorted by (decodeType, value).  16 bytes.
+struct CodeIndexEntry {
+    uint64_t value;
+    int16_t  decodeType;
+    uint16_t reserved;
+    uint32_t record;     // Record number in /codes.dat
+};
+
+class CodeLibrary {
+public:
+    CodeLibrary();
+
+    // Mount LittleFS and merge in /labels.csv.  False if there's no
+    // filesystem, in which case everything else does nothing.
+    bool begin();
+
+    bool ready() const { return _ready; }
+
+    // Find a code.  O(log n) reads of the index.
+    bool lookup(decode_type_t decodeType, uint64_t value, CodeRecord *record);
+
+    // Remember results (and its raw timings) if it's a new code.  Returns
+    // true if it was added.
+    bool add(const decode_results &results);
+
+    // The raw timings stored for a code, in microseconds.  Returns the entry
+    // count, 0 if there aren't any (or more than maxEntries).  This one is a
+    // straight read through /codes.raw, it's not meant for every capture.
+    uint16_t loadRaw(decode_type_t decodeType, uint64_t value,
+                     uint16_t *rawUsecs, uint16_t maxEntries);
+
+    // Set (or change) the label of a code, adding it if need be.
+    bool setLabel(decode_type_t decodeType, uint64_t value, uint16_t bits,
+                  const char *label);
+
+    // Read a labels CSV (see above).  Returns the number of labels changed.
+    uint16_t importLabels(const char *path);
+
+    // Every code, in index order, as CSV lines (see above).  Returns the
+    // number of codes.
+    uint32_t exportCsv(Print &out);
+
+    // Distinct codes in the library
+    uint32_t size() const { return _count; }
+
+    // Only these are kept, see above
+    static bool isLibraryCode(decode_type_t decodeType);
+
+private:
+    // Binary search.  Returns true if found; position is where it is, or
+    // where it would go.
+    bool find(int16_t decodeType, uint64_t value, uint32_t *position,
+              CodeIndexEntry *entry);
+
+    bool readRecord(uint32_t number, CodeRecord *record);
+    bool appendRecord(const CodeRecord &record, uint32_t *number);
+    bool appendRaw(const decode_results &results);
+
+    // Where the last complete entry in /codes.raw ends
+    uint32_t scanRaw();
+
+    // Point the index at record for (decodeType, value), inserting it at
+    // position if it's not there yet.
+    bool updateIndex(int16_t decodeType, uint64_t value, uint32_t record,
+                     uint32_t position, bool exists);
+
+    bool     _ready;
+    uint32_t _count;    // Entries in the index
+    uint32_t _rawSize;  // Bytes of complete entries in /codes.raw
+};
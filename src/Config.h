@@ -0,0 +1,381 @@
+/*
+    Config
+
+    Build time options that more than one source file needs to agree on.
+    Everything here can be overridden from build_flags in platformio.ini,
+    ex. -D CAPTURE_PROFILE=CAPTURE_PROFILE_TV
+*/
+#pragma once
+
+/*
+    Capture buffer profiles
+
+    The capture buffer has to hold every mark & space of the longest message
+    you expect to see.  TV/AV remotes are short, air conditioners are long,
+    and UNKNOWN junk can be any length, so size it for what you're capturing:
+
+    CAPTURE_PROFILE_TV   256 entries.  NEC, XMP, Sony, Samsung, RC5/6, etc.
+                         NEC is ~68 entries, the longest of these ~130.
+    CAPTURE_PROFILE_AC   1024 entries.  A/C protocols, the biggest of which
+                         (ex. Hitachi 424 bits) need ~850.
+    CAPTURE_PROFILE_RAW  4096 entries.  Anything, including long UNKNOWN
+                         captures.  This is what the project always used.
+
+    Each entry is a uint16_t, so RAW costs 8 KB for the ISR's buffer alone.
+*/
+#define CAPTURE_PROFILE_TV    1
+#define CAPTURE_PROFILE_AC    2
+#define CAPTURE_PROFILE_RAW   3
+
+#ifndef CAPTURE_PROFILE
+#define CAPTURE_PROFILE       CAPTURE_PROFILE_RAW
+#endif
+
+#if CAPTURE_PROFILE == CAPTURE_PROFILE_TV
+#define CAPTURE_PROFILE_BUFFER_SIZE    256
+#define CAPTURE_PROFILE_POOL_WORDS     1024
+#elif CAPTURE_PROFILE == CAPTURE_PROFILE_AC
+#define CAPTURE_PROFILE_BUFFER_SIZE    1024
+#define CAPTURE_PROFILE_POOL_WORDS     2048
+#else
+#define CAPTURE_PROFILE_BUFFER_SIZE    4096
+#define CAPTURE_PROFILE_POOL_WORDS     4096
+#endif
+
+// IRrecv capture buffer size (entries)
+#ifndef CAPTURE_BUFFER_SIZE
+#define CAPTURE_BUFFER_SIZE   CAPTURE_PROFILE_BUFFER_SIZE
+#endif
+
+// Raw timings pool shared by the queued codes (see CaptureQueue.h)
+#ifndef CAPTURE_RAW_POOL_WORDS
+#define CAPTURE_RAW_POOL_WORDS CAPTURE_PROFILE_POOL_WORDS
+#endif
+
+/*
+    CAPTURE_SAVE_BUFFER
+
+    1: IRrecv gets its own "save" buffer (same size as the capture buffer),
+       decode() copies the ISR's data into it and the receiver re-arms right
+       away.  That's double the RAM.
+    0: decode() works on the ISR's buffer in place.  The capture queue copies
+       out the (much smaller) decoded result and timings, then the receiver
+       is re-armed with resume().  Same effect, half the RAM.
+*/
+#ifndef CAPTURE_SAVE_BUFFER
+#define CAPTURE_SAVE_BUFFER   0
+#endif
+
+/*
+    ADAPTIVE_TIMEOUT
+
+    1: Learn how long a timeout each decoded protocol really needs and run
+       the receiver with the shortest safe one, going back to kTimeout for
+       UNKNOWN captures.  See AdaptiveTimeout.h.
+    0: Always use kTimeout (90 ms).
+*/
+#ifndef ADAPTIVE_TIMEOUT
+#define ADAPTIVE_TIMEOUT      0
+#endif
+
+/*
+    STAGE_STATS_INTERVAL_MS
+
+    How often to print the "[Stats]" per-stage timing lines (see
+    StageStats.h), and start a new window.  0 turns the periodic print off.
+*/
+#ifndef STAGE_STATS_INTERVAL_MS
+#define STAGE_STATS_INTERVAL_MS 60000
+#endif
+
+/*
+    BENCHMARK_MODE
+
+    1: No IR receiver.  loop() replays the captures in BenchCorpus.cpp
+       through the same decode -> Serial -> display path over and over, and
+       after every BENCHMARK_CAPTURES prints how many it got through per
+       second and the "[Stats]" timing for each stage.  Build env:esp01_bench
+       to use it.
+    0: Normal receiver.
+*/
+/*
+    SOAK_TEST
+
+    1: BENCHMARK_MODE, but without a summary after every round, for runs of
+       a day or more.  The "[Stats]" and "[Heap]" lines every
+       STAGE_STATS_INTERVAL_MS are the results, ex. check the heap slope
+       stays near 0.  Build env:esp01_soak to use it.
+    0: See BENCHMARK_MODE.
+*/
+#ifndef SOAK_TEST
+#define SOAK_TEST             0
+#endif
+
+#ifndef BENCHMARK_MODE
+#define BENCHMARK_MODE        SOAK_TEST
+#endif
+
+// Captures replayed per benchmark round
+#ifndef BENCHMARK_CAPTURES
+#define BENCHMARK_CAPTURES    100
+#endif
+
+/*
+    REPEAT_CACHE_WINDOW_MS
+
+    A code that's exactly the same as one seen less than this long ago (ex.
+    a held button re-sending full XMP frames) is counted instead of being
+    output again, and a "[Repeat]" summary line is sent once it stops.  See
+    RepeatCache.h.  0 outputs every code.
+*/
+#ifndef REPEAT_CACHE_WINDOW_MS
+#define REPEAT_CACHE_WINDOW_MS 500
+#endif
+
+/*
+    CODE_LIBRARY
+
+    1: Keep every code seen in LittleFS, with labels from /labels.csv, and
+       show a known code's label on Serial and the screen (see
+       CodeLibrary.h).  Needs a flash layout with a filesystem, see
+       env:esp01_library in platformio.ini.
+    0: No library.
+
+    CODE_LIBRARY_EXPORT_AT_BOOT prints the whole library as CSV, between
+    "[Library] BEGIN" and "[Library] END" lines, at startup.
+*/
+#ifndef CODE_LIBRARY
+#define CODE_LIBRARY          0
+#endif
+
+#ifndef CODE_LIBRARY_EXPORT_AT_BOOT
+#define CODE_LIBRARY_EXPORT_AT_BOOT 1
+#endif
+
+/*
+    NET_SINK
+
+    1: Also send every capture over Wi-Fi, batched into UDP packets, to
+       NET_COLLECTOR_HOST:NET_COLLECTOR_PORT (see NetSink.h).  Serial and
+       the screen carry on as normal.  WIFI_SSID / WIFI_PASSWORD have to be
+       set, see env:esp01_net in platformio.ini.
+    0: Serial only.
+*/
+#ifndef NET_SINK
+#define NET_SINK              0
+#endif
+
+#ifndef WIFI_SSID
+#define WIFI_SSID             ""
+#endif
+
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD         ""
+#endif
+
+// An IP address, or the default 255.255.255.255 to broadcast on the LAN
+#ifndef NET_COLLECTOR_HOST
+#define NET_COLLECTOR_HOST    "255.255.255.255"
+#endif
+
+#ifndef NET_COLLECTOR_PORT
+#define NET_COLLECTOR_PORT    5150
+#endif
+
+/*
+    IR_RECEIVER_COUNT / IR_RECEIVER_PINS
+
+    How many IR receivers, and the GPIO of each, ex. for three:
+        -D IR_RECEIVER_COUNT=3 -D IR_RECEIVER_PINS=14,12,13
+    With more than one, they're all captured at the same time by
+    EdgeCapture (see EdgeCapture.h), sharing the CAPTURE_BUFFER_SIZE
+    buffer between them, and each code says which pin it came from.  Up to
+    EdgeCapture::kMaxReceivers.
+*/
+#ifndef IR_RECEIVER_COUNT
+#define IR_RECEIVER_COUNT     1
+#endif
+
+#ifndef IR_RECEIVER_PINS
+#define IR_RECEIVER_PINS      14
+#endif
+
+/*
+    FRAME_TIMING
+
+    1: Time stamp every frame.  The pins are captured by EdgeCapture (even
+       with just the one receiver), which knows the micros() of each frame's
+       first and last edge exactly, and each code gets how long its frame
+       took, the gap since the frame before it (ex. between the NEC and XMP
+       codes of one XR2 press), and how far its marks were from the
+       protocol's nominal lengths.  See FrameTiming.h.
+    0: IRrecv's own ISR, no time stamps.
+*/
+#ifndef FRAME_TIMING
+#define FRAME_TIMING          0
+#endif
+
+// EdgeCapture does the capturing, instead of IRrecv's ISR
+#define EDGE_CAPTURE          ((IR_RECEIVER_COUNT > 1) || FRAME_TIMING)
+
+/*
+    JITTER_HISTOGRAM
+
+    1: Keep a histogram of every decoded mark's error against its nominal
+       length, over all frames since boot (held button repeats included), in
+       a fixed few hundred bytes, and print it as "[Jitter]" lines with the
+       "[Stats]" ones.  Doesn't need FRAME_TIMING.
+    0: Off.
+*/
+#ifndef JITTER_HISTOGRAM
+#define JITTER_HISTOGRAM      0
+#endif
+
+/*
+    IDLE_SLEEP
+
+    1: When there's nothing to do, loop() sleeps until the next thing it has
+       to do, or a frame starts, instead of spinning (see IdleSleep.h), and
+       the Wi-Fi radio is turned off unless NET_SINK needs it.  For running
+       from a battery.  Frames are received exactly the same.
+    0: loop() runs flat out.
+
+    IDLE_SLEEP_MAX_MS is the longest single sleep.  IDLE_SLEEP_POLL_MS is
+    how often IRrecv's ISR is checked for the first edge of a frame while
+    asleep (EdgeCapture, with FRAME_TIMING or several receivers, wakes it
+    straight away instead).
+*/
+#ifndef IDLE_SLEEP
+#define IDLE_SLEEP            0
+#endif
+
+#ifndef IDLE_SLEEP_MAX_MS
+#define IDLE_SLEEP_MAX_MS     1000
+#endif
+
+#ifndef IDLE_SLEEP_POLL_MS
+#define IDLE_SLEEP_POLL_MS    5
+#endif
+
+/*
+    RAW_FILTER
+
+    1: Tidy up every capture before it's decoded: merge glitches shorter
+       than RAW_FILTER_GLITCH_US, and throw away frames that are too short,
+       have no plausible first mark, or are mostly glitches, without trying
+       the decoders on them (see RawFilter.h).  "[Filter]" counts go out
+       with the "[Stats]" lines.
+    0: Decode exactly what was received.
+*/
+#ifndef RAW_FILTER
+#define RAW_FILTER            1
+#endif
+
+/*
+    SIGNATURE_INDEX
+
+    1: Remember the raw timings of the codes that have been decoded, and pick
+       out known ones from a new capture before decode() tries every
+       protocol on it (see SignatureIndex.h).  A "[Signature]" line with the
+       "[Stats]" shows the hits and misses.
+    0: Every capture goes through the full decode().  The default, until the
+       hit rate has been shown on real remotes.
+*/
+#ifndef SIGNATURE_INDEX
+#define SIGNATURE_INDEX       0
+#endif
+
+/*
+    PRESS_GROUP_GAP_MS
+
+    Frames received less than this far apart are one button press (ex. the
+    NEC and XMP of an XR2 button), and are output together as one BEGIN/END
+    block and one screen update once the press is over (see PressGroup.h).
+    Every code comes out up to this much later.  0 outputs every frame on
+    its own as soon as it's decoded.
+*/
+#ifndef PRESS_GROUP_GAP_MS
+#define PRESS_GROUP_GAP_MS    200
+#endif
+
+/*
+    CONSOLE
+
+    1: Serial RX is on, and takes commands to change the settings in
+       Settings.h (tolerance, timeout, verbosity, ...) and keep them in
+       LittleFS, ex. "set timeout 30" then "save".  "help" lists them.
+       RX is GPIO 3, so a receiver can't be on it (IR_RECEIVER_PINS).
+    0: TX only, as before, and always the built in settings.
+*/
+#ifndef CONSOLE
+#define CONSOLE               1
+#endif
+
+/*
+    OUTPUT_VERBOSITY
+
+    How much of the text report is sent for each code, until it's changed
+    with the console (see kVerbosity* in Settings.h):
+    2: Everything, including the A/C description and rawData[] source.
+    1: Without those two, which are most of the bytes for a long capture.
+    0: Just the code itself (protocol, code, address, command, label).
+*/
+#ifndef OUTPUT_VERBOSITY
+#define OUTPUT_VERBOSITY      2
+#endif
+
+/*
+    HEAP_STATS
+
+    1: A "[Heap]" line with the "[Stats]": free heap (and the lowest it's
+       been), largest free block, fragmentation, spare loop() stack and how
+       many captures have been handled, and how fast the free heap is
+       changing per hour since boot (see HeapStats.h).
+    0: No heap telemetry.
+*/
+#ifndef HEAP_STATS
+#define HEAP_STATS            1
+#endif
+
+/*
+    SELF_TEST
+
+    1: Loopback test, with an IR LED on IR_SEND_PIN (through a transistor,
+       ex. like IRremoteESP8266's examples) pointed at the receiver.  Known
+       codes are sent at faster and faster rates, and "[Loopback]" lines
+       report how many were decoded, how long it took and the most codes per
+       second that got through (see LoopbackTest.h).  Everything else runs
+       as normal.  Build env:esp01_loopback to use it.
+    0: Receive only.
+*/
+#ifndef SELF_TEST
+#define SELF_TEST             0
+#endif
+
+// GPIO of the IR LED for SELF_TEST, 13 is D7 on a NodeMCU / D1 mini.  Not
+// the display's SDA / SCL (4 and 5), CARRIER_PIN or a receiver pin.
+#ifndef IR_SEND_PIN
+#define IR_SEND_PIN           13
+#endif
+
+/*
+    CARRIER_METER
+
+    1: Measure each frame's carrier, with a second sensor on CARRIER_PIN
+       that passes the carrier through (ex. a TSMP58000, or a photodiode into
+       a comparator; the TSOP can't, it takes the carrier away).  Every
+       decoded code gets a "Carrier:" line with the carrier frequency and
+       duty cycle (see CarrierMeter.h).  Interrupts on every carrier edge,
+       ~76000 a second during a 38 kHz frame.
+    0: No carrier measurement.
+
+    CARRIER_PIN can't be one of IR_RECEIVER_PINS, or IR_SEND_PIN with
+    SELF_TEST, or GPIO 3 (RX) with CONSOLE.
+*/
+#ifndef CARRIER_METER
+#define CARRIER_METER         0
+#endif
+
+#ifndef CARRIER_PIN
+#define CARRIER_PIN           12
+#endif
@@ -0,0 +1,66 @@
+/*
+    Console
+
+    See Console.h
+*/
+#include "Console.h"
+
+Console::Console(const ConsoleCommand *commands, uint8_t count)
+    : _commands(commands), _count(count), _length(0), _overlong(false),
+      _commandsRun(0) {
+}
+
+void Console::poll(Stream &in, Print &out) {
+    while (in.available() > 0) {
+        char c = (char)in.read();
+        if ((c == '\n') || (c == '\r')) {
+            if (_overlong) {
+                out.println(F("[Config] line too long"));
+            } else if (_length > 0) {
+                _line[_length] = '\0';
+                run(_line, out);
+            }
+            _length   = 0;
+            _overlong = false;
+        } else if (_length < (kConsoleLineSize - 1)) {
+            _line[_length++] = c;
+        } else {
+            _overlong = true;
+        }
+    }
+}
+
+void Console::run(char *line, Print &out) {
+    // Ex. "set timeout 30": the name, then everything after its spaces
+    char *args = line;
+    while (*args && (*args != ' ')) {
+        args++;
+    }
+    if (*args) {
+        *args++ = '\0';
+        while (*args == ' ') {
+            args++;
+        }
+    }
+
+    if (strcasecmp(line, "help") == 0) {
+        // Ex. "[Config] set      <name> <value>, change one"
+        for (uint8_t i = 0; i < _count; i++) {
+            char text[96];
+            snprintf(text, sizeof(text), "[Config] %-8s %s\n",
+                     _commands[i].name, _commands[i].help);
+            out.print(text);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        if (strcasecmp(line, _commands[i].name) == 0) {
+            _commandsRun++;
+            _commands[i].run(args, out);
+            return;
+        }
+    }
+    out.print(F("[Config] unknown command: "));
+    out.println(line);
+}
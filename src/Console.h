@@ -0,0 +1,51 @@
+/*
+    Console
+
+    A line at a time command reader for the serial RX line, so settings can
+    be changed without a rebuild (see Settings.h).  poll() takes whatever
+    has arrived without waiting, and runs each line once its '\n' (or '\r')
+    arrives, ex.
+        get
+        set timeout 30
+        save
+        help
+
+    The commands themselves are a table given to the constructor, each a
+    name, a function that gets the rest of the line (leading spaces
+    skipped), and a line of help.  "help" is built in, it lists them.
+
+    Lines longer than kConsoleLineSize are thrown away whole, rather than
+    run cut short.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+const uint8_t kConsoleLineSize = 64;  // Including the '\0'
+
+struct ConsoleCommand {
+    const char *name;
+    void (*run)(const char *args, Print &out);
+    const char *help;    // Ex. "<name> <value>, change one"
+};
+
+class Console {
+public:
+    Console(const ConsoleCommand *commands, uint8_t count);
+
+    // Read what's arrived on in, and run any complete lines.  Replies (and
+    // errors) go to out.
+    void poll(Stream &in, Print &out);
+
+    uint32_t commandsRun() const { return _commandsRun; }
+
+private:
+    void run(char *line, Print &out);
+
+    const ConsoleCommand *_commands;
+    uint8_t  _count;
+    char     _line[kConsoleLineSize];
+    uint8_t  _length;
+    bool     _overlong;    // Dropping the rest of a too long line
+    uint32_t _commandsRun;
+};
@@ -0,0 +1,375 @@
+/*
+    DisplayLayer
+
+    See DisplayLayer.h for the big picture.  Dirty tracking is done in
+    physical (rotation 0) coordinates, which is how this project uses the
+    screen.  If a rotation is ever set, every draw simply marks the whole
+    screen dirty, which is no worse than calling display().
+*/
+#include "DisplayLayer.h"
+
+DisplayLayer::DisplayLayer(uint8_t w, uint8_t h, TwoWire *twi, int8_t rst_pin)
+    : Adafruit_SSD1306(w, h, twi, rst_pin, DISPLAY_I2C_CLOCK,
+                       DISPLAY_I2C_CLOCK),
+      _startLine(0), _wantedStartLine(0), _stepPage(0) {
+    // Whatever is in the panel's RAM at power up is garbage, so the first
+    // flushDirty() has to send everything.
+    markAllDirty();
+}
+
+uint8_t DisplayLayer::pageCount() const {
+    uint8_t pages = (HEIGHT + 7) / 8;
+    return (pages > kMaxPages) ? kMaxPages : pages;
+}
+
+/*
+regionDiffers
+
+Returns true if filling the (already clipped) region with color would change
+at least one pixel in the framebuffer.  Works a byte (8 pixel column) at a
+time, so checking a full page wide line is only WIDTH compares.
+*/
+bool DisplayLayer::regionDiffers(int16_t x, int16_t y, int16_t w, int16_t h,
+                                 uint16_t color) const {
+    if ((w <= 0) || (h <= 0) || (buffer == NULL)) {
+        return false;
+    }
+
+    if (color == SSD1306_INVERSE) {
+        return true;
+    }
+
+    int16_t lastRow = y + h - 1;
+    for (int16_t page = (y / 8); page <= (lastRow / 8); page++) {
+        int16_t top    = max(y, (int16_t)(page * 8));
+        int16_t bottom = min(lastRow, (int16_t)(page * 8 + 7));
+
+        // Bits of this page byte that fall inside the region
+        uint8_t mask = (uint8_t)((0xFF << (top & 7)) &
+                                 (0xFF >> (7 - (bottom & 7))));
+        uint8_t want = (color == SSD1306_WHITE) ? mask : 0x00;
+
+        const uint8_t *ptr = &buffer[page * WIDTH + x];
+        for (int16_t col = 0; col < w; col++) {
+            if ((ptr[col] & mask) != want) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void DisplayLayer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (rotation != 0) {
+        Adafruit_SSD1306::drawPixel(x, y, color);
+        markAllDirty();
+        return;
+    }
+
+    if ((x < 0) || (y < 0) || (x >= WIDTH) || (y >= HEIGHT)) {
+        return;
+    }
+
+    if (regionDiffers(x, y, 1, 1, color)) {
+        Adafruit_SSD1306::drawPixel(x, y, color);
+        markDirty(x, y, 1, 1);
+    }
+}
+
+void DisplayLayer::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                 uint16_t color) {
+    if (rotation != 0) {
+        Adafruit_SSD1306::drawFastHLine(x, y, w, color);
+        markAllDirty();
+        return;
+    }
+
+    // Clip the same way the base class will, so the check matches the draw
+    if ((y < 0) || (y >= HEIGHT)) {
+        return;
+    }
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if ((x + w) > WIDTH) {
+        w = (WIDTH - x);
+    }
+
+    if (regionDiffers(x, y, w, 1, color)) {
+        Adafruit_SSD1306::drawFastHLine(x, y, w, color);
+        markDirty(x, y, w, 1);
+    }
+}
+
+void DisplayLayer::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                 uint16_t color) {
+    if (rotation != 0) {
+        Adafruit_SSD1306::drawFastVLine(x, y, h, color);
+        markAllDirty();
+        return;
+    }
+
+    if ((x < 0) || (x >= WIDTH)) {
+        return;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if ((y + h) > HEIGHT) {
+        h = (HEIGHT - y);
+    }
+
+    if (regionDiffers(x, y, 1, h, color)) {
+        Adafruit_SSD1306::drawFastVLine(x, y, h, color);
+        markDirty(x, y, 1, h);
+    }
+}
+
+/*
+fillScreen
+
+Adafruit_GFX implements this as one drawFastVLine() per column, which would
+work, but clearing the screen is common enough to deserve a memset.  Only
+the columns that actually change are marked dirty.
+*/
+void DisplayLayer::fillScreen(uint16_t color) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    for (uint8_t page = 0; page < pageCount(); page++) {
+        uint8_t *ptr = &buffer[page * WIDTH];
+        for (int16_t col = 0; col < WIDTH; col++) {
+            uint8_t next;
+            switch (color) {
+                case SSD1306_WHITE:   next = 0xFF;     break;
+                case SSD1306_INVERSE: next = ~ptr[col]; break;
+                default:              next = 0x00;     break;
+            }
+
+            if (ptr[col] != next) {
+                ptr[col] = next;
+                markDirty(col, page * 8, 1, 8);
+            }
+        }
+    }
+}
+
+void DisplayLayer::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if ((x + w) > WIDTH) {
+        w = (WIDTH - x);
+    }
+    if ((y + h) > HEIGHT) {
+        h = (HEIGHT - y);
+    }
+    if ((w <= 0) || (h <= 0)) {
+        return;
+    }
+
+    uint8_t firstCol = (uint8_t)x;
+    uint8_t lastCol  = (uint8_t)(x + w - 1);
+
+    for (int16_t page = (y / 8); page <= ((y + h - 1) / 8); page++) {
+        if (page >= kMaxPages) {
+            break;
+        }
+        if (firstCol < _dirtyFirst[page]) {
+            _dirtyFirst[page] = firstCol;
+        }
+        if ((lastCol > _dirtyLast[page]) ||
+            (_dirtyFirst[page] > _dirtyLast[page])) {
+            _dirtyLast[page] = lastCol;
+        }
+    }
+}
+
+void DisplayLayer::markAllDirty() {
+    for (uint8_t page = 0; page < kMaxPages; page++) {
+        _dirtyFirst[page] = 0;
+        _dirtyLast[page]  = (uint8_t)(WIDTH - 1);
+    }
+}
+
+bool DisplayLayer::isDirty() const {
+    for (uint8_t page = 0; page < pageCount(); page++) {
+        if (_dirtyFirst[page] <= _dirtyLast[page]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+flushPage
+
+Point the SSD1306 column/page address window at just the dirty bytes of one
+page, then stream them.  The panel is in horizontal addressing mode (set up
+by Adafruit_SSD1306::begin()), so the data lands exactly in that window.
+*/
+void DisplayLayer::flushPage(uint8_t page, uint8_t firstCol, uint8_t lastCol) {
+    wire->beginTransmission(i2caddr);
+    wire->write((uint8_t)0x00); // Co = 0, D/C = 0: a stream of commands
+    wire->write((uint8_t)SSD1306_PAGEADDR);
+    wire->write(page);
+    wire->write(page);
+    wire->write((uint8_t)SSD1306_COLUMNADDR);
+    wire->write(firstCol);
+    wire->write(lastCol);
+    wire->endTransmission();
+
+    const uint8_t *ptr = &buffer[page * WIDTH + firstCol];
+    uint16_t count     = (lastCol - firstCol) + 1;
+
+    wire->beginTransmission(i2caddr);
+    wire->write((uint8_t)0x40); // Co = 0, D/C = 1: a stream of data
+    uint8_t bytesOut = 1;
+    while (count--) {
+        if (bytesOut >= kI2cChunkBytes) {
+            wire->endTransmission();
+            wire->beginTransmission(i2caddr);
+            wire->write((uint8_t)0x40);
+            bytesOut = 1;
+        }
+        wire->write(*ptr++);
+        bytesOut++;
+    }
+    wire->endTransmission();
+}
+
+bool DisplayLayer::flushDirty() {
+    if (!isDirty()) {
+        bool scrolled = (_startLine != _wantedStartLine);
+        sendStartLine();
+        return scrolled;
+    }
+
+    // SPI panels (no Wire) just get the stock full update.
+    if (wire == NULL) {
+        display();
+        for (uint8_t page = 0; page < kMaxPages; page++) {
+            _dirtyFirst[page] = 0xFF;
+            _dirtyLast[page]  = 0;
+        }
+        sendStartLine();
+        return true;
+    }
+
+#if ARDUINO >= 157
+    wire->setClock(wireClk);
+#endif
+
+    for (uint8_t page = 0; page < pageCount(); page++) {
+        if (_dirtyFirst[page] <= _dirtyLast[page]) {
+            flushPage(page, _dirtyFirst[page], _dirtyLast[page]);
+            _dirtyFirst[page] = 0xFF;
+            _dirtyLast[page]  = 0;
+        }
+    }
+
+#if ARDUINO >= 157
+    wire->setClock(restoreClk);
+#endif
+
+    sendStartLine();
+    return true;
+}
+
+bool DisplayLayer::flushStep() {
+    if (wire == NULL) {
+        return flushDirty();
+    }
+
+    // Carry on with the page we were on, then the ones after it
+    uint8_t pages = pageCount();
+    for (uint8_t n = 0; n < pages; n++) {
+        uint8_t page = (_stepPage + n) % pages;
+        if (_dirtyFirst[page] > _dirtyLast[page]) {
+            continue;
+        }
+
+        // One I2C transaction's worth (the data control byte + 31 columns)
+        uint8_t first = _dirtyFirst[page];
+        uint8_t last  = min(_dirtyLast[page],
+                            (uint8_t)(first + kI2cChunkBytes - 2));
+
+#if ARDUINO >= 157
+        wire->setClock(wireClk);
+#endif
+        flushPage(page, first, last);
+#if ARDUINO >= 157
+        wire->setClock(restoreClk);
+#endif
+
+        // Anything drawn in the part already sent will have moved
+        // _dirtyFirst back again by the next call, so this can't lose it.
+        if (last >= _dirtyLast[page]) {
+            _dirtyFirst[page] = 0xFF;
+            _dirtyLast[page]  = 0;
+        } else {
+            _dirtyFirst[page] = last + 1;
+        }
+
+        _stepPage = page;
+        return true;
+    }
+
+    // All the pixels are there, now it's safe to scroll
+    if (_startLine != _wantedStartLine) {
+        sendStartLine();
+        return true;
+    }
+    return false;
+}
+
+void DisplayLayer::setStartLine(uint8_t line) {
+    _wantedStartLine = (line & 0x3F);
+}
+
+void DisplayLayer::sendStartLine() {
+    if (_startLine == _wantedStartLine) {
+        return;  // Nothing to send
+    }
+
+    ssd1306_command(SSD1306_SETSTARTLINE | _wantedStartLine);
+    _startLine = _wantedStartLine;
+}
+
+void DisplayLayer::writePage(uint8_t page, int16_t x, const uint8_t *columns,
+                             uint8_t count) {
+    if ((buffer == NULL) || (page >= pageCount()) || (x < 0) ||
+        (x >= WIDTH)) {
+        return;
+    }
+
+    if (rotation != 0) {
+        // Page bytes only line up with the screen at rotation 0, so let
+        // Adafruit_GFX work out where each pixel goes.
+        for (uint8_t col = 0; col < count; col++) {
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                drawPixel(x + col, page * 8 + bit,
+                          ((columns[col] >> bit) & 1) ? SSD1306_WHITE :
+                                                        SSD1306_BLACK);
+            }
+        }
+        return;
+    }
+
+    count = min((int16_t)count, (int16_t)(WIDTH - x));
+
+    uint8_t *ptr = &buffer[page * WIDTH + x];
+    if (memcmp(ptr, columns, count) != 0) {
+        memcpy(ptr, columns, count);
+        markDirty(x, page * 8, count, 8);
+    }
+}
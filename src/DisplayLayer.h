@@ -0,0 +1,113 @@
+/*
+    DisplayLayer
+
+    A thin layer over Adafruit_SSD1306 that keeps track of which parts of the
+    framebuffer have actually changed since the last flush, and only sends
+    those bytes over I2C.
+
+    The SSD1306 framebuffer is organized as "pages" (8 pixel rows each, so 8
+    pages for a 128x64 screen) where each byte is one column of 8 pixels.  For
+    every page we remember the lowest and highest column that was touched, and
+    flushDirty() writes just that column window for each dirty page.  If nothing
+    changed, flushDirty() doesn't touch the bus at all.
+
+    All the Adafruit_GFX drawing routines (text, rects, bitmaps, etc.) end up
+    in drawPixel(), drawFastHLine() or drawFastVLine(), so overriding those is
+    enough to catch everything.  Draws that don't change any pixel (e.g.
+    re-drawing the same white dot on every loop) don't mark anything dirty.
+
+    flushDirty() sends it all in one go and waits for the bus.  flushStep()
+    sends at most one I2C transaction (31 columns) per call, so calling it
+    once per loop() spreads a screen update over many loops, and a code that
+    arrives meanwhile is never stuck behind a whole screen (1 KB at 400 kHz
+    is ~25 ms, one step is well under 1 ms).  Anything drawn in between is
+    simply picked up by the next steps.
+
+    The I2C clock used for the transfers is DISPLAY_I2C_CLOCK.  400 kHz is
+    the SSD1306's rated Fast-mode, most modules also work fine at 1 MHz
+    (Fast-mode-plus), ex. -D DISPLAY_I2C_CLOCK=1000000.
+
+    NOTE: Adafruit_SSD1306::clearDisplay() is not virtual and writes the buffer
+    directly, so use fillScreen(SSD1306_BLACK) instead (or call markAllDirty()
+    after it).
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+// I2C clock while sending to the display (and after, it's the only thing on
+// the bus).  Adafruit_SSD1306's default is 400 kHz during, 100 kHz after.
+#ifndef DISPLAY_I2C_CLOCK
+#define DISPLAY_I2C_CLOCK   400000UL
+#endif
+
+class DisplayLayer : public Adafruit_SSD1306 {
+public:
+    DisplayLayer(uint8_t w, uint8_t h, TwoWire *twi = &Wire,
+                 int8_t rst_pin = -1);
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w,
+                       uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h,
+                       uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+
+    // Mark a region (in screen pixels) as needing to be sent.
+    void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void markAllDirty();
+
+    bool isDirty() const;
+
+    // Anything at all for flushStep() to send, start line included
+    bool flushPending() const {
+        return isDirty() || (_startLine != _wantedStartLine);
+    }
+
+    // Send only the dirty page/column windows.  Returns true if anything was
+    // written to the display.
+    bool flushDirty();
+
+    // Send the next chunk of the dirty windows, if any.  Returns true if
+    // something was sent (so call it again), false once all is up to date.
+    bool flushStep();
+
+    // Which framebuffer row is shown at the top of the screen (SSD1306
+    // "display start line", 0-63).  Drawing is unaffected, it's still in
+    // framebuffer coordinates.  See ScrollLog.h.
+    //
+    // It's sent by the flush after all the dirty pixels, so a scroll never
+    // shows a page before its new contents have arrived.
+    void setStartLine(uint8_t line);
+
+    // Copy already rendered page bytes (one per column, bit 0 at the top)
+    // into page, starting at column x.  Marks dirty only if they differ.
+    void writePage(uint8_t page, int16_t x, const uint8_t *columns,
+                   uint8_t count);
+
+private:
+    // Enough for a 64 pixel tall panel (8 rows of 8 pixels each)
+    static const uint8_t kMaxPages = 8;
+
+    // Bytes per I2C transaction, including the 0x40 "data" control byte.
+    // Kept at the smallest Wire buffer we might see (AVR is 32).
+    static const uint8_t kI2cChunkBytes = 32;
+
+    uint8_t pageCount() const;
+    bool regionDiffers(int16_t x, int16_t y, int16_t w, int16_t h,
+                       uint16_t color) const;
+    void flushPage(uint8_t page, uint8_t firstCol, uint8_t lastCol);
+    void sendStartLine();
+
+    // Per page dirty window.  _dirtyFirst > _dirtyLast means page is clean.
+    uint8_t _dirtyFirst[kMaxPages];
+    uint8_t _dirtyLast[kMaxPages];
+
+    // Start line on the panel (begin() sets 0), and the one wanted
+    uint8_t _startLine;
+    uint8_t _wantedStartLine;
+
+    // Page flushStep() is working through
+    uint8_t _stepPage;
+};
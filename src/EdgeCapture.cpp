@@ -0,0 +1,138 @@
+/*
+    EdgeCapture
+
+    See EdgeCapture.h
+*/
+#include "EdgeCapture.h"
+
+// Entry 0 of every frame, the "gap before".  Like IRrecv, anything idle
+// for longer than this is just this.
+const uint16_t kEdgeLeadingGap = UINT16_MAX;
+
+void (*volatile EdgeCapture::s_frameStartHook)() = NULL;
+
+EdgeCapture::EdgeCapture()
+    : _count(0), _next(0), _timeoutMicros(kTimeoutMs * 1000UL) {
+    memset((void *)_receivers, 0, sizeof(_receivers));
+}
+
+bool EdgeCapture::begin(const uint8_t *pins, uint8_t count, uint16_t *pool,
+                        uint16_t poolSize, uint8_t timeoutMs) {
+    if ((count == 0) || (count > kMaxReceivers) || (pool == NULL)) {
+        return false;
+    }
+
+    _count = count;
+    setTimeout(timeoutMs);
+
+    uint16_t share = poolSize / count;
+    for (uint8_t i = 0; i < count; i++) {
+        Receiver &receiver = _receivers[i];
+        receiver.pin      = pins[i];
+        receiver.buffer   = &pool[i * share];
+        receiver.size     = share;
+        receiver.length   = 0;
+        receiver.done     = false;
+        receiver.overflow = false;
+
+        pinMode(receiver.pin, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(receiver.pin), onEdge,
+                           &receiver, CHANGE);
+    }
+    return true;
+}
+
+void IRAM_ATTR EdgeCapture::onEdge(void *arg) {
+    Receiver &receiver = *(Receiver *)arg;
+    uint32_t  now      = micros();
+
+    if (receiver.done) {
+        return;
+    }
+
+    if (receiver.length == 0) {
+        receiver.buffer[0]   = kEdgeLeadingGap;
+        receiver.length      = 1;
+        receiver.firstMicros = now;
+        if (s_frameStartHook != NULL) {
+            s_frameStartHook();
+        }
+    } else {
+        uint32_t ticks = (now - receiver.lastMicros) / kRawTick;
+        receiver.buffer[receiver.length++] =
+            (ticks > UINT16_MAX) ? UINT16_MAX : (uint16_t)ticks;
+
+        // Leave one spare, decode() writes a 0 after the last entry
+        if (receiver.length >= (receiver.size - 1)) {
+            receiver.overflow = true;
+            receiver.done     = true;
+        }
+    }
+    receiver.lastMicros = now;
+}
+
+int8_t EdgeCapture::nextFrame() {
+    for (uint8_t n = 0; n < _count; n++) {
+        uint8_t   index    = (_next + n) % _count;
+        Receiver &receiver = _receivers[index];
+
+        noInterrupts();
+        if (!receiver.done && (receiver.length > 0) &&
+            ((micros() - receiver.lastMicros) > _timeoutMicros)) {
+            if (receiver.length > 1) {
+                receiver.done = true;
+            } else {
+                receiver.length = 0;  // A single edge, just a glitch
+            }
+        }
+        bool ready = receiver.done;
+        interrupts();
+
+        if (ready) {
+            _next = (index + 1) % _count;
+            return (int8_t)index;
+        }
+    }
+    return -1;
+}
+
+uint16_t *EdgeCapture::frame(uint8_t receiver, uint16_t *length,
+                             bool *overflow) {
+    const Receiver &entry = _receivers[receiver];
+    *length   = entry.length;
+    *overflow = entry.overflow;
+    return entry.buffer;
+}
+
+uint32_t EdgeCapture::msUntilFrame() const {
+    uint32_t soonest = UINT32_MAX;
+    for (uint8_t i = 0; i < _count; i++) {
+        const Receiver &receiver = _receivers[i];
+
+        noInterrupts();
+        bool     done   = receiver.done;
+        uint16_t length = receiver.length;
+        uint32_t quiet  = micros() - receiver.lastMicros;
+        interrupts();
+
+        if (done) {
+            return 0;
+        }
+        if (length > 0) {
+            uint32_t wait = (quiet > _timeoutMicros)
+                ? 0 : ((_timeoutMicros - quiet) / 1000) + 1;
+            soonest = min(soonest, wait);
+        }
+    }
+    return soonest;
+}
+
+void EdgeCapture::release(uint8_t receiver) {
+    Receiver &entry = _receivers[receiver];
+
+    noInterrupts();
+    entry.length   = 0;
+    entry.overflow = false;
+    entry.done     = false;
+    interrupts();
+}
@@ -0,0 +1,96 @@
+/*
+    EdgeCapture
+
+    Capture from several IR receivers (TSOP modules) at once.
+
+    IRrecv can only have one receiver running, its ISR state is a single
+    global.  So with more than one pin, each one gets this much smaller
+    ISR instead: every edge on the pin stores the time since the previous
+    edge, in kRawTick units, into that receiver's own buffer.  That's the
+    exact same layout IRrecv's ISR makes (entry 0 is the gap before the
+    frame, then mark, space, mark, ...), so a finished frame can be handed
+    to IRrecv's decoders with replayTicks() (see RawReplay.h).
+
+    The buffers all come from one pool, split evenly between the receivers.
+
+    A frame is finished once its receiver has seen no edges for the timeout
+    (same as IRrecv), or its buffer is full.  nextFrame() looks at the
+    receivers round robin, starting after the one it returned last, so a
+    receiver that never goes quiet can't keep the others waiting.  Until
+    release(), a finished receiver ignores edges, so its frame can be read
+    in place.
+
+    Because every edge goes through here, the frame's first and last edge
+    times are known to the microsecond, which IRrecv doesn't keep (see
+    FRAME_TIMING in Config.h, which uses this even for one receiver).
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+class EdgeCapture {
+public:
+    static const uint8_t kMaxReceivers = 4;
+
+    EdgeCapture();
+
+    // Start capturing on count pins, with pool (poolSize entries) split
+    // between them.
+    bool begin(const uint8_t *pins, uint8_t count, uint16_t *pool,
+               uint16_t poolSize, uint8_t timeoutMs);
+
+    void setTimeout(uint8_t timeoutMs) { _timeoutMicros = timeoutMs * 1000UL; }
+
+    // Index of a receiver with a finished frame, or -1 if none.
+    int8_t nextFrame();
+
+    // The finished frame of receiver (valid until release()).  It can be
+    // changed in place, ex. by RawFilter.
+    uint16_t *frame(uint8_t receiver, uint16_t *length, bool *overflow);
+
+    // micros() of the first / last edge of the finished frame
+    uint32_t frameStartMicros(uint8_t receiver) const {
+        return _receivers[receiver].firstMicros;
+    }
+    uint32_t frameEndMicros(uint8_t receiver) const {
+        return _receivers[receiver].lastMicros;
+    }
+
+    // Done with the frame, start listening again.
+    void release(uint8_t receiver);
+
+    // How long until nextFrame() could have a frame: 0 if one's finished,
+    // the rest of the timeout if one is still coming in, UINT32_MAX if all
+    // the receivers are idle.
+    uint32_t msUntilFrame() const;
+
+    // Called from the ISR on the first edge of every frame, ex. to wake
+    // loop() up (see IdleSleep.h).  Must be IRAM_ATTR.
+    static void setFrameStartHook(void (*hook)()) { s_frameStartHook = hook; }
+
+    uint8_t count() const { return _count; }
+    uint8_t pin(uint8_t receiver) const { return _receivers[receiver].pin; }
+    uint16_t bufferSize() const { return _receivers[0].size; }
+
+private:
+    struct Receiver {
+        uint8_t           pin;
+        uint16_t         *buffer;
+        uint16_t          size;
+        volatile uint16_t length;      // Entries so far (0 = idle)
+        volatile uint32_t firstMicros; // Time of the frame's first edge
+        volatile uint32_t lastMicros;  // Time of the last edge
+        volatile bool     done;        // Finished, ignoring edges
+        volatile bool     overflow;    // Ran out of buffer
+    };
+
+    static void IRAM_ATTR onEdge(void *arg);
+
+    static void (*volatile s_frameStartHook)();
+
+    Receiver _receivers[kMaxReceivers];
+    uint8_t  _count;
+    uint8_t  _next;            // Where nextFrame() starts looking
+    uint32_t _timeoutMicros;
+};
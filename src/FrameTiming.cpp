@@ -0,0 +1,203 @@
+/*
+    FrameTiming
+
+    See FrameTiming.h
+*/
+#include "FrameTiming.h"
+#include <math.h>
+
+// Nominal mark lengths in us, from the IRremoteESP8266 protocol sources.
+// Unused entries are 0.
+struct NominalMarks {
+    int16_t  decodeType;
+    uint16_t marks[4];
+};
+
+static const NominalMarks kNominalMarks[] PROGMEM = {
+    { NEC,       { 9000, 560 } },             // Header, bit
+    { XMP,       { 210 } },                   // Data is all in the spaces
+    { SAMSUNG,   { 4480, 560 } },
+    { SONY,      { 2400, 1200, 600 } },       // Header, one, zero
+    { RC5,       { 889, 1778 } },             // One or two half bits
+    { RC6,       { 2666, 444, 889, 1333 } },  // Leader, 1-3 half bits
+    { JVC,       { 8400, 525 } },
+    { LG,        { 8500, 550 } },
+    { PANASONIC, { 3456, 432 } },
+    { SHARP,     { 260 } },
+};
+static const uint8_t kNominalMarksSize =
+    sizeof(kNominalMarks) / sizeof(kNominalMarks[0]);
+
+static bool findNominal(decode_type_t decodeType, NominalMarks *nominal) {
+    for (uint8_t i = 0; i < kNominalMarksSize; i++) {
+        memcpy_P(nominal, &kNominalMarks[i], sizeof(*nominal));
+        if (nominal->decodeType == (int16_t)decodeType) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+forEachMarkError
+
+Call f(error) for each mark (rawbuf[1], [3], ...) with how far it was from
+the nearest nominal length.  Marks more than half a nominal length from all
+of them (ex. a glitch) are left out.  Returns how many were passed to f.
+*/
+template<typename F>
+static uint16_t forEachMarkError(const decode_results &results, F f) {
+    NominalMarks nominal;
+    if (!findNominal(results.decode_type, &nominal)) {
+        return 0;
+    }
+
+    uint16_t count = 0;
+    for (uint16_t i = 1; i < results.rawlen; i += 2) {
+        int32_t measured = (int32_t)results.rawbuf[i] * kRawTick;
+
+        int32_t best = INT32_MAX;
+        uint16_t bestNominal = 0;
+        for (uint8_t n = 0; (n < 4) && nominal.marks[n]; n++) {
+            int32_t error = measured - nominal.marks[n];
+            if (abs(error) < abs(best)) {
+                best = error;
+                bestNominal = nominal.marks[n];
+            }
+        }
+
+        if (abs(best) <= (bestNominal / 2)) {
+            f((int16_t)best);
+            count++;
+        }
+    }
+    return count;
+}
+
+bool checkMarks(const decode_results &results, MarkCheck *check) {
+    int32_t sum   = 0;
+    int16_t worst = 0;
+
+    check->marks = forEachMarkError(results, [&](int16_t error) {
+        sum += error;
+        if (abs(error) > abs(worst)) {
+            worst = error;
+        }
+    });
+
+    if (check->marks == 0) {
+        return false;
+    }
+    check->meanError  = (int16_t)(sum / check->marks);
+    check->worstError = worst;
+    return true;
+}
+
+JitterHistogram::JitterHistogram() {
+    reset();
+}
+
+void JitterHistogram::reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count      = 0;
+    _frames     = 0;
+    _sum        = 0;
+    _sumSquares = 0;
+    _min        = INT16_MAX;
+    _max        = INT16_MIN;
+}
+
+void JitterHistogram::add(int16_t errorMicros) {
+    // Round towards -infinity, so -1 is in the bucket below 0
+    int bucket = (errorMicros >= 0)
+        ? (errorMicros / kBucketMicros)
+        : -((kBucketMicros - 1 - errorMicros) / kBucketMicros);
+    bucket += kBucketCount / 2;
+    bucket = constrain(bucket, 0, kBucketCount - 1);
+
+    if (_buckets[bucket] < UINT32_MAX) {
+        _buckets[bucket]++;
+    }
+    _count++;
+    _sum        += errorMicros;
+    _sumSquares += (uint32_t)((int32_t)errorMicros * errorMicros);
+    _min = min(_min, errorMicros);
+    _max = max(_max, errorMicros);
+}
+
+bool JitterHistogram::addFrame(const decode_results &results) {
+    uint16_t marks = forEachMarkError(results, [&](int16_t error) {
+        add(error);
+    });
+
+    if (marks == 0) {
+        return false;
+    }
+    _frames++;
+    return true;
+}
+
+int16_t JitterHistogram::percentile(uint8_t percent) const {
+    // Same rounding as StageStats::percentile()
+    uint32_t rank = ((uint64_t)_count * percent + 99) / 100;
+    uint32_t seen = 0;
+
+    for (uint8_t i = 0; i < kBucketCount; i++) {
+        seen += _buckets[i];
+        if (seen >= rank) {
+            int16_t bottom = (i - (kBucketCount / 2)) * kBucketMicros;
+            return constrain(bottom, _min, _max);
+        }
+    }
+    return _max;
+}
+
+void JitterHistogram::print(Print &out) const {
+    if (_count == 0) {
+        return;
+    }
+
+    double mean     = (double)_sum / _count;
+    double variance = ((double)_sumSquares / _count) - (mean * mean);
+
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[96];
+    snprintf(line, sizeof(line),
+        "[Jitter] marks: n=%u (%u frames) mean=%+d sd=%u min=%+d max=%+d us\n",
+        (unsigned)_count,
+        (unsigned)_frames,
+        (int)lround(mean),
+        (unsigned)lround(sqrt(max(variance, 0.0))),
+        (int)_min,
+        (int)_max);
+    out.print(line);
+
+    snprintf(line, sizeof(line), "[Jitter] p1=%+d p50=%+d p99=%+d us\n",
+        (int)percentile(1), (int)percentile(50), (int)percentile(99));
+    out.print(line);
+
+    // The non-empty buckets, by the bottom of their range, 8 to a line.
+    // Ex. "[Jitter] +44:1710 +48:5321 +52:8012"
+    uint8_t onLine = 0;
+    for (uint8_t i = 0; i < kBucketCount; i++) {
+        if (_buckets[i] == 0) {
+            continue;
+        }
+        if (onLine == 0) {
+            out.print(F("[Jitter]"));
+        }
+
+        snprintf(line, sizeof(line), " %+d:%u",
+            (int)((i - (kBucketCount / 2)) * kBucketMicros),
+            (unsigned)_buckets[i]);
+        out.print(line);
+
+        if (++onLine == 8) {
+            out.print('\n');
+            onLine = 0;
+        }
+    }
+    if (onLine) {
+        out.print('\n');
+    }
+}
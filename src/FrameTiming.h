@@ -0,0 +1,73 @@
+/*
+    FrameTiming
+
+    How close are a remote's marks to what its protocol says they should be?
+    Every decoder accepts marks within kTolerance (25%) of nominal, so a code
+    that decodes fine can still be a long way off, and that's exactly what
+    you want to know when testing another IR sending project against this.
+
+    checkMarks() compares each mark (carrier on) of one decoded frame with
+    the nearest nominal mark length of its protocol, ex. 560 us for an NEC
+    bit, and gives the average and worst error.  JitterHistogram collects the
+    same errors over as many frames as you like, in a fixed size histogram,
+    for the "[Jitter]" lines.
+
+    The errors are measured minus nominal, so positive is a long mark.  TSOP
+    style receivers typically stretch marks by a few tens of us (and shorten
+    the spaces by the same), so expect everything to sit a little positive;
+    it's the spread that shows the sender's jitter.
+
+    Only the protocols in the table in FrameTiming.cpp are checked (the
+    common TV/AV ones), anything else (ex. UNKNOWN) is skipped.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+struct MarkCheck {
+    uint16_t marks;       // Marks that were compared
+    int16_t  meanError;   // Average measured - nominal, us
+    int16_t  worstError;  // The one furthest from nominal, us (with its sign)
+};
+
+// Check every mark of a decoded frame.  Returns false if its protocol isn't
+// in the table, or none of its marks were near a nominal length.
+bool checkMarks(const decode_results &results, MarkCheck *check);
+
+class JitterHistogram {
+public:
+    // kBucketMicros per bucket, centred on 0, so +/-128 us.  Anything further
+    // out counts in the end buckets (min and max are still exact).
+    static const int16_t kBucketMicros = 4;
+    static const uint8_t kBucketCount  = 64;
+
+    JitterHistogram();
+
+    // Add the error of every mark in a decoded frame, see checkMarks().
+    bool addFrame(const decode_results &results);
+
+    // Ex.
+    // [Jitter] marks: n=21340 (320 frames) mean=+52 sd=9 min=+8 max=+96 us
+    // [Jitter] p1=+32 p50=+52 p99=+76 us
+    // [Jitter] +40:112 +44:1710 +48:5321 ...
+    void print(Print &out) const;
+
+    void reset();
+
+    uint32_t count() const { return _count; }
+
+private:
+    void add(int16_t errorMicros);
+
+    // Bottom of the bucket (error in us) the given percentile falls in
+    int16_t percentile(uint8_t percent) const;
+
+    uint32_t _buckets[kBucketCount];
+    uint32_t _count;        // Marks
+    uint32_t _frames;
+    int64_t  _sum;
+    uint64_t _sumSquares;
+    int16_t  _min;
+    int16_t  _max;
+};
@@ -0,0 +1,103 @@
+/*
+    HeapStats
+
+    See HeapStats.h
+*/
+#include "HeapStats.h"
+
+HeapStats::HeapStats()
+    : _lowFree(UINT32_MAX), _captures(0), _firstMillis(0), _samples(0),
+      _sumT(0), _sumTT(0), _sumFree(0), _sumTFree(0), _sumLargest(0),
+      _sumTLargest(0) {
+}
+
+uint32_t HeapStats::freeHeap() {
+    return ESP.getFreeHeap();
+}
+
+uint32_t HeapStats::largestBlock() {
+#if defined(ESP8266)
+    return ESP.getMaxFreeBlockSize();
+#else
+    return ESP.getMaxAllocHeap();
+#endif
+}
+
+uint8_t HeapStats::fragmentation() {
+#if defined(ESP8266)
+    return ESP.getHeapFragmentation();
+#else
+    // Same idea: how much of the free heap isn't in the largest block
+    uint32_t total = freeHeap();
+    return (total > 0) ? (uint8_t)(100 - ((largestBlock() * 100) / total)) : 0;
+#endif
+}
+
+uint32_t HeapStats::stackFree() {
+#if defined(ESP8266)
+    return ESP.getFreeContStack();
+#else
+    return uxTaskGetStackHighWaterMark(NULL);
+#endif
+}
+
+void HeapStats::check() {
+    uint32_t free = freeHeap();
+    if (free < _lowFree) {
+        _lowFree = free;
+    }
+}
+
+// Least squares slope of y over t, 0 until there are two samples
+static double slope(double n, double sumT, double sumTT, double sumY,
+                    double sumTY) {
+    double d = (n * sumTT) - (sumT * sumT);
+    return (d > 0) ? (((n * sumTY) - (sumT * sumY)) / d) : 0;
+}
+
+void HeapStats::print(Print &out, uint32_t nowMillis) {
+    check();
+    uint32_t free    = freeHeap();
+    uint32_t largest = largestBlock();
+
+    if (_samples == 0) {
+        _firstMillis = nowMillis;
+    }
+    double hours = (nowMillis - _firstMillis) / 3600000.0;
+    _samples++;
+    _sumT        += hours;
+    _sumTT       += hours * hours;
+    _sumFree     += free;
+    _sumTFree    += hours * free;
+    _sumLargest  += largest;
+    _sumTLargest += hours * largest;
+
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[128];
+    snprintf(line, sizeof(line),
+        "[Heap] free %u (low %u), largest %u, frag %u%%, stack free %u, "
+        "%u captures\n",
+        (unsigned)free,
+        (unsigned)_lowFree,
+        (unsigned)largest,
+        (unsigned)fragmentation(),
+        (unsigned)stackFree(),
+        (unsigned)_captures);
+    out.print(line);
+
+    double n = _samples;
+    int32_t freeSlope    = (int32_t)slope(n, _sumT, _sumTT, _sumFree,
+                                          _sumTFree);
+    int32_t largestSlope = (int32_t)slope(n, _sumT, _sumTT, _sumLargest,
+                                          _sumTLargest);
+    uint32_t tenths = (uint32_t)(hours * 10);
+    snprintf(line, sizeof(line),
+        "[Heap] slope free %d B/h, largest %d B/h over %u.%u h "
+        "(%u samples)\n",
+        (int)freeSlope,
+        (int)largestSlope,
+        (unsigned)(tenths / 10),
+        (unsigned)(tenths % 10),
+        (unsigned)_samples);
+    out.print(line);
+}
@@ -0,0 +1,60 @@
+/*
+    HeapStats
+
+    Memory health over a long session.  A receiver that's been up for a day
+    can stop sending the rawData[] block, which looks like the heap has
+    fragmented until there's no single block big enough for a String
+    (resultAcToString(), and the network and filesystem code, still use
+    them).
+
+    check() is cheap (no heap walk) and is called after every capture to
+    catch the lowest the free heap goes.  print() does the rest, once per
+    "[Stats]" window:
+        [Heap] free 23456 (low 21000), largest 18000, frag 12%,
+               stack free 3100, 4012 captures
+        [Heap] slope free -12 B/h, largest -40 B/h over 24.0 h (145 samples)
+
+    The slope is a least squares fit over every print() since boot, so a
+    steady leak shows up as a negative number that stays put, while the odd
+    big allocation washes out.  "frag" is ESP.getHeapFragmentation(): 0% is
+    all of the free heap in one block, near 100% is lots of small ones.
+
+    "stack free" is the least the loop() stack (4 KB on the ESP8266) has had
+    spare since boot, from the core's painted stack.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+class HeapStats {
+public:
+    HeapStats();
+
+    // Note the free heap now, ex. after a capture has been output
+    void check();
+
+    // Captures handled, for the "[Heap]" line
+    void countCaptures(uint32_t count) { _captures += count; }
+
+    // Take a sample for the slope and print the "[Heap]" lines
+    void print(Print &out, uint32_t nowMillis);
+
+private:
+    static uint32_t freeHeap();
+    static uint32_t largestBlock();
+    static uint8_t  fragmentation();
+    static uint32_t stackFree();
+
+    uint32_t _lowFree;
+    uint32_t _captures;
+
+    // Least squares sums, t in hours since the first sample
+    uint32_t _firstMillis;
+    uint32_t _samples;
+    double   _sumT;
+    double   _sumTT;
+    double   _sumFree;
+    double   _sumTFree;
+    double   _sumLargest;
+    double   _sumTLargest;
+};
@@ -0,0 +1,98 @@
+/*
+    IdleSleep
+
+    See IdleSleep.h
+*/
+#include "IdleSleep.h"
+#include "RawReplay.h"
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#include <coredecls.h>
+#endif
+
+static volatile bool s_wakeRequested = false;
+
+IdleSleep::IdleSleep() {
+    reset();
+}
+
+void IdleSleep::begin(bool needRadio) {
+#if defined(ESP8266)
+    if (!needRadio) {
+        WiFi.persistent(false);
+        WiFi.mode(WIFI_OFF);
+        WiFi.forceSleepBegin();
+    }
+#else
+    (void)needRadio;
+#endif
+}
+
+void IRAM_ATTR IdleSleep::wake() {
+    s_wakeRequested = true;
+#if defined(ESP8266)
+    esp_schedule();  // Ends the esp_delay() in sleep() straight away
+#endif
+}
+
+bool IdleSleep::irrecvIdle() {
+    return _IRrecv::params.rcvstate == kIdleState;
+}
+
+void IdleSleep::sleep(uint32_t ms, bool (*stillIdle)(), uint32_t pollMs) {
+    if (ms == 0) {
+        return;
+    }
+
+    auto idle = [stillIdle]() {
+        return !s_wakeRequested && ((stillIdle == NULL) || stillIdle());
+    };
+
+    uint32_t start = micros();
+#if defined(ESP8266)
+    esp_delay(ms, idle, max(pollMs, (uint32_t)1));
+#else
+    uint32_t startMillis = millis();
+    while (idle() && ((millis() - startMillis) < ms)) {
+        delay(min(pollMs, ms));
+    }
+#endif
+    uint32_t slept = micros() - start;
+
+    // A wake() from before this sleep (ex. an edge while loop() was busy)
+    // has done its job by now too
+    bool early = !idle();
+    s_wakeRequested = false;
+
+    _sleeps++;
+    _sleptMicros += slept;
+    if (early) {
+        _earlyWakes++;
+    }
+}
+
+void IdleSleep::reset() {
+    _sleeps      = 0;
+    _earlyWakes  = 0;
+    _sleptMicros = 0;
+}
+
+void IdleSleep::print(Print &out, uint32_t windowMs) const {
+    if (windowMs == 0) {
+        return;
+    }
+
+    uint32_t permille = (uint32_t)min((uint64_t)1000,
+                                      _sleptMicros / windowMs);
+
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[96];
+    snprintf(line, sizeof(line),
+        "[Idle] asleep %u.%u%% of %u ms (%u sleeps, %u woken early)\n",
+        (unsigned)(permille / 10),
+        (unsigned)(permille % 10),
+        (unsigned)windowMs,
+        (unsigned)_sleeps,
+        (unsigned)_earlyWakes);
+    out.print(line);
+}
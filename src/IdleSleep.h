@@ -0,0 +1,57 @@
+/*
+    IdleSleep
+
+    Nearly all of the time a receiver is waiting for someone to press a
+    button, and loop() would spin round checking decode(), the display and
+    the TX buffer thousands of times a second for nothing.
+
+    sleep() parks loop() in esp_delay() instead, where the SDK leaves the
+    CPU waiting for an interrupt, until one of:
+        - the time main.cpp worked out until the next thing it has to do
+          (a repeat summary, the stats, a network batch) is up
+        - wake() is called, from an ISR, ex. EdgeCapture's first edge
+        - stillIdle() says otherwise, checked every pollMs, for IRrecv's own
+          ISR, which has no hook (see irrecvIdle())
+
+    Interrupts keep running throughout, so the IR ISR sees the first edge of
+    a frame exactly as it would with loop() spinning; there's no wake up
+    delay to lose it in.  Output only starts (up to pollMs) later.
+
+    begin(false) also turns the Wi-Fi radio off, which on its own is most of
+    an idle ESP8266's current (~70 mA of ~80), and it's on by default even
+    though this project never used it.
+
+    This isn't the SDK's "forced light sleep" (wifi_fpm_do_sleep()): that
+    stops the CPU clock and timers, so micros() and IRrecv's timeout would
+    stop too, and the frame that woke it would be lost.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+class IdleSleep {
+public:
+    IdleSleep();
+
+    // needRadio false: turn Wi-Fi off
+    void begin(bool needRadio);
+
+    // Sleep for up to ms (see above).  stillIdle can be NULL.
+    void sleep(uint32_t ms, bool (*stillIdle)(), uint32_t pollMs);
+
+    // From an ISR (or anywhere): end the current sleep now
+    static void IRAM_ATTR wake();
+
+    // True while IRrecv's ISR is waiting for the first edge of a frame
+    static bool irrecvIdle();
+
+    // Ex. "[Idle] asleep 97.2% of 60000 ms (812 sleeps, 14 woken early)"
+    void print(Print &out, uint32_t windowMs) const;
+
+    void reset();
+
+private:
+    uint32_t _sleeps;
+    uint32_t _earlyWakes;  // Ended by wake() / stillIdle(), not the time
+    uint64_t _sleptMicros;
+};
@@ -0,0 +1,49 @@
+/*
+    LabelCache
+
+    See LabelCache.h
+*/
+#include "LabelCache.h"
+
+LabelCache::LabelCache(DisplayLayer &display)
+    : _display(display), _count(0) {
+}
+
+bool LabelCache::add(PGM_P label) {
+    uint8_t *buffer = _display.getBuffer();
+    size_t   length = strlen_P(label);
+    if ((_count >= kMaxLabels) || (length == 0) ||
+        (length > kMaxLabelChars) || (buffer == NULL)) {
+        return false;
+    }
+
+    Label &entry  = _labels[_count];
+    uint8_t width = length * kCharWidth;
+
+    // Draw it into page 0, keep the bytes, then blank it again
+    _display.fillRect(0, 0, width, 8, SSD1306_BLACK);
+    _display.setTextSize(1);
+    _display.setTextWrap(false);
+    _display.setTextColor(SSD1306_WHITE);
+    _display.setCursor(0, 0);
+    _display.print(FPSTR(label));
+    memcpy(entry.columns, buffer, width);
+    _display.fillRect(0, 0, width, 8, SSD1306_BLACK);
+
+    entry.text   = label;
+    entry.length = length;
+    _count++;
+    return true;
+}
+
+uint8_t LabelCache::draw(const char *text, uint8_t page) {
+    for (uint8_t i = 0; i < _count; i++) {
+        const Label &entry = _labels[i];
+        if (strncmp_P(text, entry.text, entry.length) == 0) {
+            _display.writePage(page, 0, entry.columns,
+                               entry.length * kCharWidth);
+            return entry.length;
+        }
+    }
+    return 0;
+}
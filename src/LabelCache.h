@@ -0,0 +1,51 @@
+/*
+    LabelCache
+
+    Every result on the display starts with the same few labels ("Protocol: ",
+    "Code    : ", ...), and Adafruit_GFX draws text a pixel at a time, so
+    most of the time spent drawing a result went into drawing labels that
+    never change.
+
+    add() draws a label once, with the same font and size as ScrollLog uses,
+    and keeps the framebuffer bytes it produced: one byte per pixel column,
+    exactly the layout of a framebuffer page.  From then on ScrollLog asks
+    draw() first, and a line that starts with a cached label gets those bytes
+    memcpy()'d straight into its page.  Only the rest of the line (the value)
+    is drawn through Adafruit_GFX.
+
+    The bytes are captured from the real font at boot rather than baked into
+    PROGMEM, so they can't get out of step with the font the library has.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "DisplayLayer.h"
+
+class LabelCache {
+public:
+    explicit LabelCache(DisplayLayer &display);
+
+    // Render and keep label (a PROGMEM string).  This draws over the top
+    // left of the framebuffer, so do it before anything is on the screen.
+    // Returns false if it's too long or the cache is full.
+    bool add(PGM_P label);
+
+    // If text starts with a cached label, copy it into page at column 0 and
+    // return how many characters of text it covers.  Otherwise 0.
+    uint8_t draw(const char *text, uint8_t page);
+
+private:
+    static const uint8_t kMaxLabels     = 6;
+    static const uint8_t kMaxLabelChars = 10;
+    static const uint8_t kCharWidth     = 6;  // 5x7 font + 1 column gap
+
+    struct Label {
+        PGM_P   text;
+        uint8_t length;
+        uint8_t columns[kMaxLabelChars * kCharWidth];
+    };
+
+    DisplayLayer &_display;
+    Label   _labels[kMaxLabels];
+    uint8_t _count;
+};
@@ -0,0 +1,203 @@
+/*
+    LoopbackTest
+
+    See LoopbackTest.h
+*/
+#include "LoopbackTest.h"
+
+// The codes sent, round robin.  Add to it with any protocol IRsend::send()
+// can do; one that isn't compiled in (both SEND_ and DECODE_) is left out.
+// Each one is sent as is and has to match what decode() reports, so the
+// protocol and bits have to be what comes back, not just what send() takes.
+static const LoopbackCode kLoopbackSuite[] PROGMEM = {
+#if SEND_NEC && DECODE_NEC
+    { NEC,     32, 0x20DF40BFULL },          // Vizio Vol+
+#endif
+#if SEND_XMP && DECODE_XMP
+    { XMP,     64, 0x170F443E14008300ULL },  // XR2 NOP
+#endif
+#if SEND_SAMSUNG && DECODE_SAMSUNG
+    { SAMSUNG, 32, 0xE0E040BFULL },          // Samsung TV power
+#endif
+#if SEND_SONY && DECODE_SONY
+    { SONY,    12, 0xA90ULL },               // Sony TV power
+#endif
+#if SEND_RC5 && DECODE_RC5
+    { RC5,     12, 0x00CULL },               // 13 bits would be RC5X
+#endif
+    { UNKNOWN, 0,  0 }                       // End marker, never sent
+};
+static const uint8_t kLoopbackSuiteSize =
+    (sizeof(kLoopbackSuite) / sizeof(kLoopbackSuite[0])) - 1;
+
+// Codes per second to try, in order, until one fails
+static const uint8_t kLoopbackRates[] = { 1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20 };
+static const uint8_t kLoopbackRateCount = sizeof(kLoopbackRates);
+
+LoopbackTest::LoopbackTest(IRsend &send)
+    : _send(send), _suiteSize(kLoopbackSuiteSize), _rateIndex(0),
+      _lastPassed(0), _pausing(false), _pauseStart(0), _nextCode(0),
+      _pendingCount(0) {
+    startStep(0);
+}
+
+void LoopbackTest::begin() {
+    _send.begin();
+    startStep(micros());
+}
+
+void LoopbackTest::startStep(uint32_t nowMicros) {
+    _stepStart    = nowMicros;
+    _nextSend     = nowMicros;
+    _lastSendEnd  = nowMicros;
+    _sentInStep   = 0;
+    _pendingCount = 0;
+    _decoded      = 0;
+    _missed       = 0;
+    _unexpected   = 0;
+    _latencySum   = 0;
+    _latencyMin   = UINT32_MAX;
+    _latencyMax   = 0;
+}
+
+void LoopbackTest::retire(uint8_t count) {
+    memmove(&_pending[0], &_pending[count],
+            (_pendingCount - count) * sizeof(_pending[0]));
+    _pendingCount -= count;
+}
+
+void LoopbackTest::received(const decode_results &results) {
+    if (_pausing || results.repeat) {
+        return;
+    }
+
+    // The oldest outstanding send it matches.  Anything sent before that
+    // one has been overtaken, so it's not coming.
+    for (uint8_t i = 0; i < _pendingCount; i++) {
+        const LoopbackCode &code = _pending[i].code;
+        if ((code.decodeType == (int16_t)results.decode_type) &&
+            (code.bits == results.bits) && (code.value == results.value)) {
+            uint32_t latency = micros() - _pending[i].endMicros;
+            _decoded++;
+            _missed += i;
+            _latencySum += latency;
+            _latencyMin  = min(_latencyMin, latency);
+            _latencyMax  = max(_latencyMax, latency);
+            retire(i + 1);
+            return;
+        }
+    }
+
+    // Ex. more frames of a protocol that always sends repeats (Sony), a
+    // bad decode, or some other remote
+    _unexpected++;
+}
+
+void LoopbackTest::finishStep(Print &out) {
+    uint8_t  rate    = kLoopbackRates[_rateIndex];
+    uint16_t percent = _sentInStep ? ((_decoded * 100U) / _sentInStep) : 0;
+    uint32_t elapsed = max(_lastSendEnd - _stepStart, (uint32_t)1);
+    uint32_t achievedX10 = ((uint64_t)_sentInStep * 10000000ULL) / elapsed;
+    uint32_t average = _decoded ? (_latencySum / _decoded) : 0;
+
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[160];
+    snprintf(line, sizeof(line),
+        "[Loopback] %u/s: %u sent (%u.%u/s), %u decoded (%u%%), "
+        "%u unexpected, latency %u/%u/%u ms (min/avg/max)\n",
+        (unsigned)rate,
+        (unsigned)_sentInStep,
+        (unsigned)(achievedX10 / 10),
+        (unsigned)(achievedX10 % 10),
+        (unsigned)_decoded,
+        (unsigned)percent,
+        (unsigned)_unexpected,
+        (unsigned)(_decoded ? (_latencyMin / 1000) : 0),
+        (unsigned)(average / 1000),
+        (unsigned)(_latencyMax / 1000));
+    out.print(line);
+
+    bool passed = (percent >= LOOPBACK_PASS_PERCENT);
+    if (passed) {
+        _lastPassed = rate;
+    }
+    if (passed && ((_rateIndex + 1) < kLoopbackRateCount)) {
+        _rateIndex++;
+        startStep(micros());
+        return;
+    }
+
+    // Ex. "[Loopback] max sustainable 6 codes/s"
+    snprintf(line, sizeof(line), "[Loopback] max sustainable %u codes/s\n",
+             (unsigned)_lastPassed);
+    out.print(line);
+
+    _rateIndex  = 0;
+    _lastPassed = 0;
+    _pausing    = true;
+    _pauseStart = millis();
+}
+
+void LoopbackTest::poll(Print &out) {
+    if (_suiteSize == 0) {
+        return;
+    }
+
+    if (_pausing) {
+        if ((millis() - _pauseStart) < LOOPBACK_PAUSE_MS) {
+            return;
+        }
+        _pausing = false;
+        startStep(micros());
+    }
+
+    // Sends that never came back
+    uint32_t now = micros();
+    while (_pendingCount &&
+           ((now - _pending[0].endMicros) > (LOOPBACK_TIMEOUT_MS * 1000UL))) {
+        _missed++;
+        retire(1);
+    }
+
+    if (_sentInStep >= LOOPBACK_CODES_PER_STEP) {
+        if (_pendingCount == 0) {
+            finishStep(out);
+        }
+        return;
+    }
+
+    if ((int32_t)(now - _nextSend) < 0) {
+        return;
+    }
+    if (_pendingCount >= kOutstanding) {
+        _missed++;  // Oldest can't be tracked any more, call it lost
+        retire(1);
+    }
+
+    Sent &sent = _pending[_pendingCount];
+    memcpy_P(&sent.code, &kLoopbackSuite[_nextCode], sizeof(sent.code));
+    _nextCode = (_nextCode + 1) % _suiteSize;
+
+    // The next one is due a fixed time after this one started, however
+    // long this one takes to send
+    _nextSend += 1000000UL / kLoopbackRates[_rateIndex];
+    _send.send((decode_type_t)sent.code.decodeType, sent.code.value,
+               sent.code.bits);
+
+    sent.endMicros = micros();
+    _lastSendEnd   = sent.endMicros;
+    _pendingCount++;
+    _sentInStep++;
+}
+
+uint32_t LoopbackTest::msUntilPoll() const {
+    if (_pausing) {
+        uint32_t paused = millis() - _pauseStart;
+        return (paused < LOOPBACK_PAUSE_MS) ? (LOOPBACK_PAUSE_MS - paused) : 0;
+    }
+    if (_pendingCount) {
+        return 1;  // Mostly waiting on received(), but check for misses
+    }
+    int32_t untilSend = (int32_t)(_nextSend - micros());
+    return (untilSend > 0) ? (uint32_t)(untilSend / 1000) : 0;
+}
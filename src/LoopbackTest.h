@@ -0,0 +1,114 @@
+/*
+    LoopbackTest
+
+    A self test of the whole receive path, with an IR LED on IR_SEND_PIN
+    pointed at the receiver.  It sends a suite of known codes with IRsend
+    (kLoopbackSuite in LoopbackTest.cpp: NEC, XMP, Samsung, ... whichever of
+    them are compiled in), and checks each one comes back out of decode()
+    as the same protocol and value.
+
+    It goes in steps of increasing rate (kLoopbackRates codes per second),
+    LOOPBACK_CODES_PER_STEP codes each, and after every step prints
+    something like
+        [Loopback] 4/s: 30 sent (3.9/s), 30 decoded (100%), 0 unexpected,
+                   latency 97/101/118 ms (min/avg/max)
+    Once a step decodes fewer than LOOPBACK_PASS_PERCENT of its codes (or
+    the last rate has passed), the run ends with
+        [Loopback] max sustainable 6 codes/s
+    and starts again after a pause.
+
+    Latency is from the end of the send (IRsend::send() only returns once
+    the last mark is out) to received() being given the decoded result, so
+    it's mostly the receiver timeout, plus the decode.  The rest of the
+    pipeline (capture queue, Serial, screen) runs as normal while this is
+    going on, so if it can't keep up its drops show in the "Queue" line.
+
+    IRsend bit-bangs the 38 kHz carrier, so loop() is stuck in send() for
+    the length of each frame.  IR capture is all interrupts, so that
+    doesn't matter to the receiver.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#include <IRsend.h>
+
+// Codes sent at each rate
+#ifndef LOOPBACK_CODES_PER_STEP
+#define LOOPBACK_CODES_PER_STEP 30
+#endif
+
+// A rate passes if at least this many of its codes were decoded (%)
+#ifndef LOOPBACK_PASS_PERCENT
+#define LOOPBACK_PASS_PERCENT 95
+#endif
+
+// A code not decoded by this long after it was sent is a miss (ms)
+#ifndef LOOPBACK_TIMEOUT_MS
+#define LOOPBACK_TIMEOUT_MS   500
+#endif
+
+// Between the end of one run and the start of the next (ms)
+#ifndef LOOPBACK_PAUSE_MS
+#define LOOPBACK_PAUSE_MS     10000
+#endif
+
+struct LoopbackCode {
+    int16_t  decodeType;
+    uint16_t bits;
+    uint64_t value;
+};
+
+class LoopbackTest {
+public:
+    explicit LoopbackTest(IRsend &send);
+
+    // Set up the LED pin, and start with the first rate
+    void begin();
+
+    // Send the next code if it's due, and count the ones that never came
+    // back.  Prints each step's result as it finishes.
+    void poll(Print &out);
+
+    // Every decoded result (repeats and all), as soon as it's decoded
+    void received(const decode_results &results);
+
+    // How long until poll() has something to do
+    uint32_t msUntilPoll() const;
+
+private:
+    static const uint8_t kOutstanding = 8;  // Sent, not yet decoded
+
+    struct Sent {
+        LoopbackCode code;
+        uint32_t     endMicros;  // When send() returned
+    };
+
+    void startStep(uint32_t nowMicros);
+    void finishStep(Print &out);
+    void retire(uint8_t count);
+
+    IRsend  &_send;
+    uint8_t  _suiteSize;     // Codes in the suite that can be sent
+    uint8_t  _rateIndex;     // Into kLoopbackRates
+    uint8_t  _lastPassed;    // Rate that last passed, 0 if none yet
+    bool     _pausing;
+    uint32_t _pauseStart;    // millis()
+
+    uint32_t _stepStart;     // micros() of the first send of the step
+    uint32_t _nextSend;      // micros() the next send is due
+    uint16_t _sentInStep;
+    uint8_t  _nextCode;      // Into the suite, round robin
+
+    Sent     _pending[kOutstanding];
+    uint8_t  _pendingCount;
+
+    // This step's results
+    uint16_t _decoded;
+    uint16_t _missed;
+    uint16_t _unexpected;
+    uint32_t _latencySum;    // us
+    uint32_t _latencyMin;
+    uint32_t _latencyMax;
+    uint32_t _lastSendEnd;   // micros(), for the achieved rate
+};
@@ -0,0 +1,183 @@
+/*
+    NetSink
+
+    See NetSink.h.  The pool is a ring: _first is the oldest finished packet,
+    the _sealed packets after it are waiting to be sent, and the one after
+    those is the one being filled.
+*/
+#include "NetSink.h"
+#include "BinaryReport.h"
+
+size_t NetSink::PacketWriter::write(uint8_t c) {
+    if (_packet.length >= NET_PACKET_SIZE) {
+        overflow = true;
+        return 0;
+    }
+    _packet.data[_packet.length++] = c;
+    return 1;
+}
+
+NetSink::NetSink()
+    : _first(0), _sealed(0), _fillMillis(0), _port(0), _started(false),
+      _sequence(0), _packetsSent(0), _framesSent(0), _packetsDropped(0) {
+    startPacket(filling());
+}
+
+void NetSink::begin(const char *ssid, const char *password, const char *host,
+                    uint16_t port) {
+    if (!_host.fromString(host)) {
+        _host = IPAddress(255, 255, 255, 255);
+    }
+    _port = port;
+
+    WiFi.persistent(false);  // Don't wear the flash saving the same config
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(ssid, password);
+
+    _udp.begin(port);
+    _started = true;
+}
+
+bool NetSink::connected() const {
+    return _started && (WiFi.status() == WL_CONNECTED);
+}
+
+void NetSink::startPacket(Packet &packet) {
+    packet.length = kNetHeaderSize;
+    packet.frames = 0;
+}
+
+void NetSink::writeHeader(uint8_t *header, uint8_t frames) {
+    uint32_t chipId = ESP.getChipId();
+
+    header[0] = 'I';
+    header[1] = 'R';
+    header[2] = kNetVersion;
+    header[3] = frames;
+    for (uint8_t i = 0; i < 4; i++) {
+        header[4 + i] = (uint8_t)(chipId >> (8 * i));
+        header[8 + i] = (uint8_t)(_sequence >> (8 * i));
+    }
+    _sequence++;
+}
+
+void NetSink::sealPacket() {
+    _sealed++;
+    if (_sealed >= NET_PACKET_POOL) {
+        // Nowhere left to build the next one, lose the oldest
+        _first = (_first + 1) % NET_PACKET_POOL;
+        _sealed--;
+        _packetsDropped++;
+    }
+    startPacket(filling());
+}
+
+template<typename Writer>
+void NetSink::sendOversize(Writer writer) {
+    if (!connected()) {
+        _packetsDropped++;
+        return;
+    }
+
+    uint8_t header[kNetHeaderSize];
+    writeHeader(header, 1);
+
+    _udp.beginPacket(_host, _port);
+    _udp.write(header, sizeof(header));
+    writer(_udp);
+    if (_udp.endPacket()) {
+        _packetsSent++;
+        _framesSent++;
+    } else {
+        _packetsDropped++;
+    }
+}
+
+/*
+addFrame
+
+Write one frame (writer(Print &)) into the packet being filled.  If it
+doesn't fit, what was written is taken back off, the packet is sealed and
+the frame goes into a fresh one instead.
+*/
+template<typename Writer>
+void NetSink::addFrame(Writer writer) {
+    if (!_started) {
+        return;
+    }
+
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        Packet &packet = filling();
+        uint16_t start = packet.length;
+
+        PacketWriter out(packet);
+        writer(out);
+        if (!out.overflow) {
+            if (packet.frames++ == 0) {
+                _fillMillis = millis();
+            }
+            return;
+        }
+
+        packet.length = start;
+        if (packet.frames == 0) {
+            break;  // Too big even for an empty packet
+        }
+        sealPacket();
+    }
+
+    sendOversize(writer);
+}
+
+void NetSink::addCapture(const decode_results &results,
+                         const CaptureRecord &record) {
+    addFrame([&](Print &out) {
+        printBinaryReport(out, results, record);
+    });
+}
+
+void NetSink::addRepeat(const RepeatEntry &entry) {
+    addFrame([&](Print &out) {
+        printBinaryRepeat(out, entry);
+    });
+}
+
+uint32_t NetSink::msUntilPoll(uint32_t now, uint32_t retryMs) const {
+    if (_sealed > 0) {
+        return connected() ? 0 : retryMs;
+    }
+
+    const Packet &packet = _pool[(_first + _sealed) % NET_PACKET_POOL];
+    if (packet.frames == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = now - _fillMillis;
+    return (elapsed >= NET_BATCH_MS) ? 0 : (NET_BATCH_MS - elapsed);
+}
+
+void NetSink::poll(uint32_t now) {
+    Packet &packet = filling();
+    if ((packet.frames > 0) && ((now - _fillMillis) >= NET_BATCH_MS)) {
+        sealPacket();
+    }
+
+    if ((_sealed == 0) || !connected()) {
+        return;
+    }
+
+    Packet &ready = _pool[_first];
+    writeHeader(ready.data, ready.frames);
+
+    _udp.beginPacket(_host, _port);
+    _udp.write(ready.data, ready.length);
+    if (_udp.endPacket()) {
+        _packetsSent++;
+        _framesSent += ready.frames;
+    } else {
+        _packetsDropped++;
+    }
+
+    _first = (_first + 1) % NET_PACKET_POOL;
+    _sealed--;
+}
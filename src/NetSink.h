@@ -0,0 +1,136 @@
+/*
+    NetSink
+
+    Sends captures to a collector over Wi-Fi (UDP), so a receiver doesn't
+    need a PC on its USB port, and a rack of them can all report to one
+    place.
+
+    Each capture (and "[Repeat]" summary) is the same CRC checked binary
+    frame as OUTPUT_FORMAT_BINARY sends on Serial (see BinaryReport.h), and
+    several of them are batched into one UDP packet:
+
+        'I' 'R'             Magic
+        uint8               Version (kNetVersion)
+        uint8               Number of frames in the packet
+        uint32 (LE)         ESP.getChipId(), which receiver this is
+        uint32 (LE)         Packet sequence number (to spot lost packets)
+        frames...
+
+    A packet is sent once the next frame won't fit or NET_BATCH_MS after its
+    first frame went in, whichever is first.  tools/irrecord_binary.py
+    --udp PORT is a collector for them.
+
+    Packets come from a fixed pool, built in place, so there's no heap use
+    per capture.  If Wi-Fi is down the finished packets wait in the pool,
+    and when it's full the oldest is dropped (and counted).  A single frame
+    bigger than a pool packet (a long UNKNOWN capture) is sent on its own,
+    straight into the UDP stack.
+
+    Sending is done from poll(), one packet per call.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#endif
+#include <WiFiUdp.h>
+#include "CaptureQueue.h"
+#include "RepeatCache.h"
+
+// Pool of UDP packets being built / waiting to go
+#ifndef NET_PACKET_POOL
+#define NET_PACKET_POOL      4
+#endif
+
+// Bytes per packet, header included.  Kept under the 1472 byte UDP payload
+// of a 1500 byte MTU so nothing gets fragmented.
+#ifndef NET_PACKET_SIZE
+#define NET_PACKET_SIZE      1024
+#endif
+
+// Longest a capture waits for others to share its packet
+#ifndef NET_BATCH_MS
+#define NET_BATCH_MS         250
+#endif
+
+const uint8_t kNetVersion    = 1;
+const uint8_t kNetHeaderSize = 12;
+
+class NetSink {
+public:
+    NetSink();
+
+    // Start connecting to Wi-Fi (doesn't wait).  host is an IP address
+    // string, ex. "192.168.1.20", or "255.255.255.255" to broadcast.
+    void begin(const char *ssid, const char *password, const char *host,
+               uint16_t port);
+
+    // Add a capture / repeat summary to the current packet.
+    void addCapture(const decode_results &results,
+                    const CaptureRecord &record);
+    void addRepeat(const RepeatEntry &entry);
+
+    // Finish a packet whose batch time is up, and send one if Wi-Fi is up.
+    void poll(uint32_t now);
+
+    bool connected() const;
+
+    // How long poll() can be left before it has something to do: 0 if a
+    // packet is ready to go, the rest of the batch time if one is filling,
+    // UINT32_MAX if there's nothing.  Waiting for Wi-Fi counts as retryMs.
+    uint32_t msUntilPoll(uint32_t now, uint32_t retryMs) const;
+
+    uint32_t packetsSent() const { return _packetsSent; }
+    uint32_t framesSent() const { return _framesSent; }
+    uint32_t packetsDropped() const { return _packetsDropped; }
+
+private:
+    struct Packet {
+        uint16_t length;
+        uint8_t  frames;
+        uint8_t  data[NET_PACKET_SIZE];
+    };
+
+    // A Print that fills a Packet, and notes if it ran out of room
+    class PacketWriter : public Print {
+    public:
+        explicit PacketWriter(Packet &packet)
+            : overflow(false), _packet(packet) {}
+        size_t write(uint8_t c) override;
+        using Print::write;
+
+        bool overflow;
+
+    private:
+        Packet &_packet;
+    };
+
+    template<typename Writer> void addFrame(Writer writer);
+
+    Packet &filling() { return _pool[(_first + _sealed) % NET_PACKET_POOL]; }
+    void startPacket(Packet &packet);
+    void sealPacket();
+    void writeHeader(uint8_t *header, uint8_t frames);
+
+    // Send a frame that doesn't fit in a packet on its own
+    template<typename Writer> void sendOversize(Writer writer);
+
+    Packet    _pool[NET_PACKET_POOL];
+    uint8_t   _first;       // Oldest sealed packet
+    uint8_t   _sealed;      // Packets finished and waiting to be sent
+    uint32_t  _fillMillis;  // When the first frame went into filling()
+
+    WiFiUDP   _udp;
+    IPAddress _host;
+    uint16_t  _port;
+    bool      _started;
+
+    uint32_t  _sequence;
+    uint32_t  _packetsSent;
+    uint32_t  _framesSent;
+    uint32_t  _packetsDropped;
+};
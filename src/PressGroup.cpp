@@ -0,0 +1,70 @@
+/*
+    PressGroup
+
+    See PressGroup.h
+*/
+#include "PressGroup.h"
+
+PressGroup::PressGroup(uint32_t gapMs)
+    : _gapMs(gapMs), _presses(0), _frames(0), _mostFrames(0) {
+}
+
+uint8_t PressGroup::ready(const CaptureQueue &queue, uint32_t now) const {
+    uint16_t waiting = queue.size();
+    if (waiting == 0) {
+        return 0;
+    }
+    if (_gapMs == 0) {
+        return 1;
+    }
+
+    // A later frame too far after the one before it starts the next press
+    const CaptureRecord *last = queue.at(0);
+    for (uint16_t i = 1; i < waiting; i++) {
+        const CaptureRecord *record = queue.at(i);
+        if ((record->captureMillis - last->captureMillis) > _gapMs) {
+            return (uint8_t)i;
+        }
+        last = record;
+    }
+
+    // Otherwise it's all one press so far, and might not be finished
+    if ((waiting >= CAPTURE_QUEUE_DEPTH) ||
+        ((now - last->captureMillis) > _gapMs)) {
+        return (uint8_t)waiting;
+    }
+    return 0;
+}
+
+uint32_t PressGroup::msUntilReady(const CaptureQueue &queue,
+                                  uint32_t now) const {
+    uint16_t waiting = queue.size();
+    if (waiting == 0) {
+        return UINT32_MAX;
+    }
+    if (ready(queue, now) > 0) {
+        return 0;
+    }
+
+    uint32_t since = now - queue.at(waiting - 1)->captureMillis;
+    return (_gapMs + 1) - since;
+}
+
+void PressGroup::add(uint8_t frames) {
+    _presses++;
+    _frames += frames;
+    if (frames > _mostFrames) {
+        _mostFrames = frames;
+    }
+}
+
+void PressGroup::print(Print &out) const {
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[80];
+    snprintf(line, sizeof(line),
+        "[Press] %u presses, %u frames, at most %u in one\n",
+        (unsigned)_presses,
+        (unsigned)_frames,
+        (unsigned)_mostFrames);
+    out.print(line);
+}
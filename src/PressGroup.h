@@ -0,0 +1,52 @@
+/*
+    PressGroup
+
+    One press of a Comcast/XR2 button sends an NEC frame then an XMP one
+    (three frames for "All Power"), and each used to come out as a BEGIN/END
+    block and a screen update of its own, the first often before the next
+    had even been received.
+
+    ready() looks at the frames waiting in the capture queue and says how
+    many at the front make up one press: frames less than gapMs apart (by
+    CaptureRecord::captureMillis) are the same press.  It says 0 until the
+    press is complete, that is a later frame has come in more than gapMs
+    after its last one, or gapMs has gone by with nothing, or the queue is
+    full.  outputStage() then sends them all as one block and one screen
+    update.
+
+    So every code is output up to gapMs later than it would be on its own;
+    that's the price of knowing there's nothing else coming.  A gapMs of 0
+    makes every frame its own press, the same as without this.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "CaptureQueue.h"
+
+class PressGroup {
+public:
+    explicit PressGroup(uint32_t gapMs);
+
+    // Frames at the front of queue that make up the next complete press,
+    // or 0 if there isn't one yet.
+    uint8_t ready(const CaptureQueue &queue, uint32_t now) const;
+
+    // How long until ready() will have a press (0 if it does now), or
+    // UINT32_MAX if the queue is empty.
+    uint32_t msUntilReady(const CaptureQueue &queue, uint32_t now) const;
+
+    void setGapMs(uint32_t gapMs) { _gapMs = gapMs; }
+
+    // Count a press of frames that's been output
+    void add(uint8_t frames);
+
+    // Ex. "[Press] 40 presses, 64 frames, at most 3 in one"
+    void print(Print &out) const;
+
+private:
+    uint32_t _gapMs;
+
+    uint32_t _presses;
+    uint32_t _frames;
+    uint8_t  _mostFrames;
+};
@@ -0,0 +1,151 @@
+/*
+    RawCodec
+
+    See RawCodec.h for the format.
+*/
+#include "RawCodec.h"
+#include "Varint.h"
+
+// Smallest timing of each protocol, in us.  The unit is 1/8th of it.
+struct ProtocolTick {
+    int16_t  decodeType;
+    uint16_t tickUs;
+};
+
+static const ProtocolTick kProtocolTicks[] PROGMEM = {
+    { NEC,       560 },
+    { XMP,       135 },   // The nibble step of the spaces
+    { SAMSUNG,   560 },
+    { SONY,      600 },
+    { RC5,       889 },
+    { RC6,       444 },
+    { JVC,       525 },
+    { LG,        550 },
+    { PANASONIC, 432 },
+    { SHARP,     260 },
+};
+static const uint8_t kProtocolTicksSize =
+    sizeof(kProtocolTicks) / sizeof(kProtocolTicks[0]);
+
+uint8_t rawQuantum(decode_type_t decodeType) {
+#if RAW_CODEC_QUANTIZE
+    for (uint8_t i = 0; i < kProtocolTicksSize; i++) {
+        ProtocolTick entry;
+        memcpy_P(&entry, &kProtocolTicks[i], sizeof(entry));
+        if (entry.decodeType == (int16_t)decodeType) {
+            // A whole number of ticks, so nothing is lost to rounding twice
+            uint16_t quantum = (entry.tickUs / 8 / kRawTick) * kRawTick;
+            return (uint8_t)max(quantum, (uint16_t)kRawTick);
+        }
+    }
+    return RAW_CODEC_DEFAULT_QUANTUM_US;
+#else
+    (void)decodeType;
+    return kRawTick;
+#endif  // RAW_CODEC_QUANTIZE
+}
+
+// Send the zero run so far (if any) as tokens
+static size_t flushRun(Print &out, uint16_t *run) {
+    size_t written = 0;
+    if (*run == 1) {
+        written = writeVarint(out, 0);
+    } else if (*run > 1) {
+        written = writeVarint(out, ((uint32_t)(*run - 2) << 1) | 1);
+    }
+    *run = 0;
+    return written;
+}
+
+size_t encodeRaw(Print &out, const uint16_t *rawTicks, uint16_t count,
+                 uint8_t quantumUs) {
+    if (quantumUs == 0) {
+        quantumUs = kRawTick;
+    }
+
+    out.write(quantumUs);
+    size_t written = 1 + writeVarint(out, count);
+
+    uint32_t previous[2] = {0, 0};  // Last mark, last space (units)
+    uint16_t run = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t usecs = (uint32_t)rawTicks[i] * kRawTick;
+        uint32_t units = (usecs + (quantumUs / 2)) / quantumUs;
+
+        int32_t delta = (int32_t)units - (int32_t)previous[i & 1];
+        previous[i & 1] = units;
+
+        if (delta == 0) {
+            run++;
+            continue;
+        }
+        written += flushRun(out, &run);
+        written += writeVarint(out, (uint64_t)zigzagEncode(delta) << 1);
+    }
+    written += flushRun(out, &run);
+    return written;
+}
+
+size_t encodeRaw(Print &out, const decode_results &results) {
+    // rawbuf[0] is the gap before the message, left out like rawData[]
+    uint16_t count = (results.rawlen > 0) ? (results.rawlen - 1) : 0;
+    return encodeRaw(out, (const uint16_t *)&results.rawbuf[1], count,
+                     rawQuantum(results.decode_type));
+}
+
+// Read one varint, false if it runs off the end
+static bool readVarint(const uint8_t *data, size_t size, size_t *pos,
+                       uint32_t *value) {
+    *value = 0;
+    for (uint8_t shift = 0; (*pos < size) && (shift < 35); shift += 7) {
+        uint8_t b = data[(*pos)++];
+        *value |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t decodeRaw(const uint8_t *data, size_t size, uint16_t *rawUsecs,
+                   uint16_t maxEntries) {
+    size_t   pos = 0;
+    uint32_t count;
+    if ((size < 2) || (data[0] == 0)) {
+        return 0;
+    }
+    uint8_t quantumUs = data[pos++];
+    if (!readVarint(data, size, &pos, &count) || (count > maxEntries)) {
+        return 0;
+    }
+
+    int32_t  previous[2] = {0, 0};
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t token;
+        if (!readVarint(data, size, &pos, &token)) {
+            return 0;
+        }
+
+        // A zero run repeats the entry two before, one difference changes it
+        uint32_t repeat = (token & 1) ? ((token >> 1) + 2) : 1;
+        int32_t  delta  = (token & 1) ? 0 : zigzagDecode(token >> 1);
+        if ((i + repeat) > count) {
+            return 0;
+        }
+
+        for (uint32_t n = 0; n < repeat; n++, i++) {
+            int32_t units = previous[i & 1] + delta;
+            if (units < 0) {
+                return 0;
+            }
+            previous[i & 1] = units;
+
+            // A saturated gap (UINT16_MAX ticks) comes back as the most a
+            // uint16_t can hold, same as rawData[] would have it
+            uint32_t usecs = (uint32_t)units * quantumUs;
+            rawUsecs[i] = (uint16_t)min(usecs, (uint32_t)UINT16_MAX);
+        }
+    }
+    return (uint16_t)count;
+}
@@ -0,0 +1,61 @@
+/*
+    RawCodec
+
+    A compact encoding of raw IR timings, for everywhere they're stored or
+    sent: the binary frames (Serial and NetSink) and the code library.
+
+    rawData[] as text is ~5 characters per entry, and as uint16_t it's 2
+    bytes, but most of it says the same thing over and over: every NEC mark
+    is ~560 us, every space one of two lengths.  So:
+
+    1. Quantize.  Each timing is rounded to a unit of rawQuantum() us, 1/8th
+       of its protocol's smallest timing (ex. 70 us for NEC), 10 us for
+       UNKNOWN and anything else.  That's comfortably inside the decoders'
+       tolerance, so a replayed code decodes the same, but the receiver's
+       noise in the last few us is gone.  RAW_CODEC_QUANTIZE 0 keeps every
+       tick for jitter measurements (kRawTick, 2 us, same as rawbuf).
+    2. Delta.  Each unit count is sent as its difference from the entry two
+       before it (mark vs mark, space vs space), so most are 0 or +/-1.
+    3. Run length.  A run of 0 differences is a single token.
+
+    Encoded:
+        uint8               Microseconds per unit
+        varint              Entry count (not counting the leading gap)
+        tokens, each a varint:
+            even            One entry, zigzag difference = token >> 1
+            odd             (token >> 1) + 2 entries, all difference 0
+
+    A typical NEC capture (67 entries, 134 bytes as uint16_t) comes out at
+    about 40 bytes.  tools/irrecord_binary.py has the same decoder.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+// Round to a fraction of the protocol's tick (1), or keep every tick (0)
+#ifndef RAW_CODEC_QUANTIZE
+#define RAW_CODEC_QUANTIZE    1
+#endif
+
+// Microseconds per unit for protocols not in the table, ex. UNKNOWN
+#ifndef RAW_CODEC_DEFAULT_QUANTUM_US
+#define RAW_CODEC_DEFAULT_QUANTUM_US 10
+#endif
+
+// Unit size to encode decodeType's timings with (see above)
+uint8_t rawQuantum(decode_type_t decodeType);
+
+// Encode count timings (kRawTick units, ex. &results.rawbuf[1], so without
+// the leading gap).  Returns the number of bytes written.
+size_t encodeRaw(Print &out, const uint16_t *rawTicks, uint16_t count,
+                 uint8_t quantumUs);
+
+// The same, for a decoded capture
+size_t encodeRaw(Print &out, const decode_results &results);
+
+// Decode size bytes back to microseconds (the layout replayDecode() and
+// rawData[] use).  Returns the entry count, or 0 if it's not valid or has
+// more than maxEntries.
+uint16_t decodeRaw(const uint8_t *data, size_t size, uint16_t *rawUsecs,
+                   uint16_t maxEntries);
@@ -0,0 +1,93 @@
+/*
+    RawFilter
+
+    See RawFilter.h
+*/
+#include "RawFilter.h"
+#include "RawReplay.h"
+
+// Fewest entries a real frame has: gap, mark, space, mark
+const uint16_t kRawFilterMinEntries = 4;
+
+RawFilter::RawFilter(uint16_t glitchUs, uint16_t minFirstMarkUs)
+    : _glitchTicks(glitchUs / kRawTick),
+      _minFirstMarkTicks(minFirstMarkUs / kRawTick),
+      _frames(0), _glitches(0), _short(0), _noHeader(0), _noisy(0) {
+}
+
+static uint16_t addTicks(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t sum = a + b + c;
+    return (sum > UINT16_MAX) ? UINT16_MAX : (uint16_t)sum;
+}
+
+bool RawFilter::apply(uint16_t *ticks, uint16_t *length) {
+    uint16_t count    = *length;
+    uint16_t glitches = 0;
+    _frames++;
+
+    // Entry 0 (the gap before) is kept as is.  w only ever trails r, so
+    // it's safe to do in place, and marks stay at odd indexes.
+    uint16_t w = 1;
+    for (uint16_t r = 1; r < count; r++) {
+        uint16_t value = ticks[r];
+        if (value >= _glitchTicks) {
+            ticks[w++] = value;
+            continue;
+        }
+
+        glitches++;
+        if (w == 1) {
+            r++;            // Leading: drop it and the entry after it
+        } else if ((r + 1) < count) {
+            ticks[w - 1] = addTicks(ticks[w - 1], value, ticks[r + 1]);
+            r++;            // Fold it and the next into the one before
+        } else if (w & 1) {
+            w--;            // Trailing mark: drop it and the space before
+        }                   // Trailing space: just drop it
+    }
+
+    *length    = w;
+    _glitches += glitches;
+
+    if (w < kRawFilterMinEntries) {
+        _short++;
+        return false;
+    }
+    if (ticks[1] < _minFirstMarkTicks) {
+        _noHeader++;
+        return false;
+    }
+    if ((uint32_t)glitches * 4 > count) {
+        _noisy++;
+        return false;
+    }
+    return true;
+}
+
+bool RawFilter::applyToReceiver() {
+    volatile irparams_t &params = _IRrecv::params;
+    if (params.rcvstate != kStopState) {
+        return true;  // Nothing finished to look at
+    }
+
+    // The ISR is stopped until resume(), so the buffer is ours for now
+    uint16_t length = params.rawlen;
+    bool keep = apply((uint16_t *)params.rawbuf, &length);
+    params.rawlen = length;
+    return keep;
+}
+
+void RawFilter::print(Print &out) const {
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[112];
+    snprintf(line, sizeof(line),
+        "[Filter] %u frames, %u glitches merged, %u rejected "
+        "(%u short, %u no header, %u noisy)\n",
+        (unsigned)_frames,
+        (unsigned)_glitches,
+        (unsigned)rejected(),
+        (unsigned)_short,
+        (unsigned)_noHeader,
+        (unsigned)_noisy);
+    out.print(line);
+}
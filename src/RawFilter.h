@@ -0,0 +1,70 @@
+/*
+    RawFilter
+
+    A cheap pass over a finished capture's raw timings before decode() sees
+    it.  Under fluorescent lights or in sunlight the receiver picks up bursts
+    of short junk pulses, sometimes enough to fill the whole capture buffer,
+    and decode() then tries every compiled in protocol on it before the
+    UNKNOWN size check finally throws it away.
+
+    apply() does three things, in place, on IRrecv's layout (kRawTick units,
+    entry 0 the gap before the frame):
+
+    1. Merge glitches.  A mark or space shorter than glitchUs can't be real
+       IR (the shortest protocol timings are ~200 us), so it's folded into
+       the entries either side of it, ex. mark 560, space 40, mark 520
+       becomes one 1120 mark.  One at the very start or end is dropped
+       (with its neighbour if need be), so the frame still starts and ends
+       with a mark.
+    2. Reject frames too short to be anything (fewer than a mark, space,
+       mark, like an NEC repeat), or whose first mark is shorter than
+       minFirstMarkUs (every protocol starts with a header or bit mark).
+    3. Reject frames where more than 1 in 4 entries were glitches: that's
+       noise with the odd longer pulse in it.
+
+    What it drops is counted, so the "[Filter]" line shows how noisy the
+    room is.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+// Shorter than this is a glitch (us)
+#ifndef RAW_FILTER_GLITCH_US
+#define RAW_FILTER_GLITCH_US  80
+#endif
+
+// A frame's first mark has to be at least this long (us)
+#ifndef RAW_FILTER_MIN_FIRST_MARK_US
+#define RAW_FILTER_MIN_FIRST_MARK_US 150
+#endif
+
+class RawFilter {
+public:
+    RawFilter(uint16_t glitchUs, uint16_t minFirstMarkUs);
+
+    // Filter length entries of ticks in place (length is updated).  Returns
+    // false if it should be thrown away without decoding.
+    bool apply(uint16_t *ticks, uint16_t *length);
+
+    // The same on IRrecv's own capture buffer, if it has a finished frame.
+    // Returns false if it should be thrown away (resume() the receiver).
+    bool applyToReceiver();
+
+    // Ex. "[Filter] 812 frames, 3140 glitches merged, 96 rejected (12 short,
+    //      40 no header, 44 noisy)"
+    void print(Print &out) const;
+
+    uint32_t rejected() const { return _short + _noHeader + _noisy; }
+
+private:
+    uint16_t _glitchTicks;
+    uint16_t _minFirstMarkTicks;
+
+    uint32_t _frames;
+    uint32_t _glitches;
+    uint32_t _short;
+    uint32_t _noHeader;
+    uint32_t _noisy;
+};
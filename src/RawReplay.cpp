@@ -0,0 +1,47 @@
+/*
+    RawReplay
+
+    See RawReplay.h
+*/
+#include "RawReplay.h"
+
+// rawbuf[0] is the gap before the message, which the decoders skip.  Use
+// something bigger than any timeout, like a long quiet period.
+const uint16_t kReplayLeadingGap = UINT16_MAX;
+
+bool replayDecode(IRrecv &recv, const uint16_t *rawUsecs, uint16_t rawLen,
+                  decode_results *results) {
+    volatile irparams_t &params = _IRrecv::params;
+
+    // Entry 0 is the leading gap, and decode() writes a 0 just past the end
+    // of the data, so leave room for both.
+    uint16_t room  = (params.bufsize > 2) ? (params.bufsize - 2) : 0;
+    uint16_t count = min(rawLen, room);
+
+    params.rawbuf[0] = kReplayLeadingGap;
+    for (uint16_t i = 0; i < count; i++) {
+        // Same rounding the ISR does: elapsed microseconds / kRawTick
+        params.rawbuf[i + 1] = pgm_read_word(&rawUsecs[i]) / kRawTick;
+    }
+
+    params.rawlen   = count + 1;
+    params.overflow = (count < rawLen);
+    params.rcvstate = kStopState;  // "A message is ready", as if timed out
+
+    return recv.decode(results);
+}
+
+bool replayTicks(IRrecv &recv, const uint16_t *rawTicks, uint16_t rawLen,
+                 bool overflow, decode_results *results) {
+    volatile irparams_t &params = _IRrecv::params;
+
+    uint16_t room  = (params.bufsize > 1) ? (params.bufsize - 1) : 0;
+    uint16_t count = min(rawLen, room);
+
+    memcpy(params.rawbuf, rawTicks, count * sizeof(uint16_t));
+    params.rawlen   = count;
+    params.overflow = overflow || (count < rawLen);
+    params.rcvstate = kStopState;
+
+    return recv.decode(results);
+}
@@ -0,0 +1,46 @@
+/*
+    RawReplay
+
+    Feed a recorded list of mark/space timings to IRrecv::decode() as if it
+    had just been received, with no IR hardware involved.
+
+    For replayDecode() the timings are in microseconds, exactly as printed
+    in the rawData[] array of the "[resultsToSourceCode]" output, so
+    captures can be pasted straight in.  They can be in RAM or PROGMEM.
+
+    IRrecv has no public way to do this, so the timings are written into the
+    library's receive state (_IRrecv::params, the same thing its ISR fills in)
+    and it's marked as a finished message.  The receiver must be stopped
+    (disableIRIn()) first, so the ISR and timer don't touch it meanwhile.
+    Afterwards it's left idle, call resume() or enableIRIn() to go back to
+    receiving for real.
+
+    This relies on IRrecv internals (checked against IRremoteESP8266 2.8.6),
+    so it's only meant for when IRrecv's own ISR isn't being used: test
+    harnesses like the benchmark build, and EdgeCapture.
+
+    The declaration of _IRrecv::params is here for everything else that
+    looks at what the ISR captured (IdleSleep, RawFilter, SignatureIndex),
+    so a library change only breaks the one place.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+// IRrecv's receive state.  Not in IRrecv.h, but not static either (it's
+// defined in IRrecv.cpp).
+namespace _IRrecv {
+extern volatile irparams_t params;
+}
+
+// Decode rawLen timings (microseconds, RAM or PROGMEM) through recv.
+// Returns whatever decode() does.  Timings that don't fit the receiver's
+// buffer are dropped and flagged as an overflow, like a real capture.
+bool replayDecode(IRrecv &recv, const uint16_t *rawUsecs, uint16_t rawLen,
+                  decode_results *results);
+
+// The same, for timings already in IRrecv's own layout (kRawTick units,
+// entry 0 the gap before the frame, in RAM), ex. from EdgeCapture.
+bool replayTicks(IRrecv &recv, const uint16_t *rawTicks, uint16_t rawLen,
+                 bool overflow, decode_results *results);
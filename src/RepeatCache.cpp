@@ -0,0 +1,129 @@
+/*
+    RepeatCache
+
+    See RepeatCache.h
+*/
+#include "RepeatCache.h"
+#include <IRutils.h>
+
+const uint32_t kFnvOffset = 2166136261UL;
+const uint32_t kFnvPrime  = 16777619UL;
+
+static uint32_t fnvAdd(uint32_t hash, const uint8_t *data, size_t length) {
+    while (length--) {
+        hash = (hash ^ *data++) * kFnvPrime;
+    }
+    return hash;
+}
+
+RepeatCache::RepeatCache(uint32_t windowMs)
+    : _windowMs(windowMs), _totalHits(0) {
+    memset(_entries, 0, sizeof(_entries));
+}
+
+uint32_t RepeatCache::hashOf(const decode_results &results) {
+    int16_t  decodeType = (int16_t)results.decode_type;
+    uint16_t bits       = results.bits;
+
+    uint32_t hash = kFnvOffset;
+    hash = fnvAdd(hash, (const uint8_t *)&decodeType, sizeof(decodeType));
+    hash = fnvAdd(hash, (const uint8_t *)&bits, sizeof(bits));
+
+    if (hasACState(results.decode_type)) {
+        size_t nbytes = min((uint16_t)((bits + 7) / 8), kStateSizeMax);
+        hash = fnvAdd(hash, results.state, nbytes);
+    } else {
+        hash = fnvAdd(hash, (const uint8_t *)&results.value,
+                      sizeof(results.value));
+    }
+    return hash;
+}
+
+bool RepeatCache::seen(const decode_results &results, uint32_t now) {
+    if (_windowMs == 0) {
+        return false;
+    }
+
+    uint32_t hash = hashOf(results);
+    bool hasState = hasACState(results.decode_type);
+    uint64_t value = hasState ? 0 : results.value;
+
+    RepeatEntry *unused = NULL;
+    RepeatEntry *oldest = NULL;
+    for (uint8_t i = 0; i < kSlots; i++) {
+        RepeatEntry &entry = _entries[i];
+        if (!entry.used) {
+            if (unused == NULL) {
+                unused = &entry;
+            }
+            continue;
+        }
+
+        if ((entry.hash == hash) &&
+            (entry.decodeType == (int16_t)results.decode_type) &&
+            (entry.bits == results.bits) && (entry.value == value) &&
+            ((now - entry.lastMillis) <= _windowMs)) {
+            entry.lastMillis = now;
+            if (entry.hits < UINT16_MAX) {
+                entry.hits++;
+            }
+            _totalHits++;
+            return true;
+        }
+
+        if ((oldest == NULL) ||
+            ((now - entry.lastMillis) > (now - oldest->lastMillis))) {
+            oldest = &entry;
+        }
+    }
+
+    // UNKNOWN codes are hashes of (possibly partial) noise, not worth
+    // remembering
+    if (results.decode_type == UNKNOWN) {
+        return false;
+    }
+
+    // All in use: the least recently seen one loses its hits (it's the
+    // least likely to still be held down)
+    RepeatEntry *slot = (unused != NULL) ? unused : oldest;
+    slot->hash        = hash;
+    slot->value       = value;
+    slot->decodeType  = (int16_t)results.decode_type;
+    slot->bits        = results.bits;
+    slot->firstMillis = now;
+    slot->lastMillis  = now;
+    slot->hits        = 0;
+    slot->used        = true;
+    return false;
+}
+
+bool RepeatCache::takeExpired(uint32_t now, RepeatEntry *entry) {
+    for (uint8_t i = 0; i < kSlots; i++) {
+        RepeatEntry &slot = _entries[i];
+        if (!slot.used || ((now - slot.lastMillis) <= _windowMs)) {
+            continue;
+        }
+
+        slot.used = false;
+        if (slot.hits > 0) {
+            *entry = slot;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t RepeatCache::msUntilExpired(uint32_t now) const {
+    uint32_t soonest = UINT32_MAX;
+    for (uint8_t i = 0; i < kSlots; i++) {
+        const RepeatEntry &slot = _entries[i];
+        if (!slot.used || (slot.hits == 0)) {
+            continue;  // Nothing to report, it just goes quietly
+        }
+
+        uint32_t quiet = now - slot.lastMillis;
+        uint32_t wait  = (quiet > _windowMs) ? 0 : (_windowMs + 1 - quiet);
+        soonest = min(soonest, wait);
+    }
+    return soonest;
+}
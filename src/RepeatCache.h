@@ -0,0 +1,68 @@
+/*
+    RepeatCache
+
+    Holding a button down on most remotes sends NEC style "repeat" frames,
+    which captureStage() already ignores.  But some (XMP/Comcast, Samsung,
+    Sony, ...) send the whole frame again every ~100 ms instead, and every
+    one of those used to get the full Serial dump and a screen update, which
+    kept the link and the screen busy while new codes waited.
+
+    seen() remembers each (protocol, value, bits) it's given for a short
+    window.  If the same code comes in again before the window closes, it's
+    counted as a hit (and the window starts again) instead of being output.
+    Once a code has gone quiet for the window, takeExpired() hands back its
+    entry so the hits can be reported as one summary line, ex.
+        [Repeat] XMP 0x170F443E14008300 (64 bits) x12 over 1320 ms
+
+    The key is hashed (FNV-1a) so a lookup is one compare per slot, and A/C
+    protocols (where there is no value) are keyed on their whole state[].
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#include "Config.h"
+
+// Codes tracked at once (up to 255)
+#ifndef REPEAT_CACHE_SLOTS
+#define REPEAT_CACHE_SLOTS    8
+#endif
+
+struct RepeatEntry {
+    uint32_t hash;
+    uint64_t value;        // 0 for A/C (state[]) protocols
+    int16_t  decodeType;
+    uint16_t bits;
+    uint32_t firstMillis;  // When the code was first output
+    uint32_t lastMillis;   // Last time it was seen
+    uint16_t hits;         // Times it was seen again, and not output
+    bool     used;
+};
+
+class RepeatCache {
+public:
+    explicit RepeatCache(uint32_t windowMs);
+
+    // True if results is the same as a code seen within the window (and
+    // counts it).  False if not, and it's remembered from now on.
+    bool seen(const decode_results &results, uint32_t now);
+
+    // Take out one entry that's gone quiet for the window and had hits,
+    // to report.  Quiet entries with no hits are just dropped.
+    bool takeExpired(uint32_t now, RepeatEntry *entry);
+
+    // How long until takeExpired() will have something to report (0 if it
+    // does now), or UINT32_MAX if nothing's being held.
+    uint32_t msUntilExpired(uint32_t now) const;
+
+    uint32_t totalHits() const { return _totalHits; }
+
+private:
+    static const uint8_t kSlots = REPEAT_CACHE_SLOTS;
+
+    static uint32_t hashOf(const decode_results &results);
+
+    RepeatEntry _entries[kSlots];
+    uint32_t    _windowMs;
+    uint32_t    _totalHits;
+};
@@ -0,0 +1,76 @@
+/*
+    ReportWriter
+
+    See ReportWriter.h
+*/
+#include "ReportWriter.h"
+
+ReportWriter::ReportWriter(Print &out) : _out(out), _used(0) {
+}
+
+ReportWriter::~ReportWriter() {
+    flush();
+}
+
+size_t ReportWriter::write(uint8_t c) {
+    if (_used >= kBufferSize) {
+        flush();
+    }
+    _buffer[_used++] = (char)c;
+    return 1;
+}
+
+size_t ReportWriter::write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        if (_used >= kBufferSize) {
+            flush();
+        }
+
+        size_t chunk = min((size_t)(kBufferSize - _used), (size - written));
+        memcpy(&_buffer[_used], &buffer[written], chunk);
+        _used   += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+size_t ReportWriter::printf(const char *format, ...) {
+    va_list args;
+
+    // Try to fit it in after what's already buffered
+    va_start(args, format);
+    int len = vsnprintf(&_buffer[_used], (kBufferSize - _used), format, args);
+    va_end(args);
+
+    if (len < 0) {
+        return 0;
+    }
+
+    if ((size_t)len >= (size_t)(kBufferSize - _used)) {
+        // Didn't fit, send what we have and format again at the start.
+        // (vsnprintf always needs room for the '\0', hence the >=)
+        flush();
+
+        va_start(args, format);
+        len = vsnprintf(_buffer, kBufferSize, format, args);
+        va_end(args);
+
+        if (len < 0) {
+            return 0;
+        }
+        if (len >= (int)kBufferSize) {
+            len = (kBufferSize - 1); // Truncated
+        }
+    }
+
+    _used += len;
+    return len;
+}
+
+void ReportWriter::flush() {
+    if (_used) {
+        _out.write((const uint8_t *)_buffer, _used);
+        _used = 0;
+    }
+}
@@ -0,0 +1,40 @@
+/*
+    ReportWriter
+
+    A Print that collects output in a small fixed buffer and hands it to
+    another Print (ex. Serial) in chunks.  Nothing is ever allocated on the
+    heap, which is the whole point: the String based IRremoteESP8266 helpers
+    (resultToSourceCode() especially) allocate tens of KB for long captures
+    and fragment the heap over a long session.
+
+    Also provides its own printf(), because Print::printf() falls back to
+    new[] when the formatted text is longer than its 64 byte stack buffer.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+class ReportWriter : public Print {
+public:
+    explicit ReportWriter(Print &out);
+    ~ReportWriter();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    // Formats straight into the buffer.  Output longer than the whole
+    // buffer is truncated, so keep each call to one line or so.
+    size_t printf(const char *format, ...)
+        __attribute__((format(printf, 2, 3)));
+
+    // Send whatever is buffered to the output.
+    void flush() override;
+
+private:
+    static const uint16_t kBufferSize = 128;
+
+    Print   &_out;
+    char     _buffer[kBufferSize];
+    uint16_t _used;
+};
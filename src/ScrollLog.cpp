@@ -0,0 +1,97 @@
+/*
+    ScrollLog
+
+    See ScrollLog.h
+*/
+#include "ScrollLog.h"
+
+ScrollLog::ScrollLog(DisplayLayer &display)
+    : _display(display), _labels(NULL), _column(0), _lineCount(0), _cleared(false) {
+    memset(_lines, 0, sizeof(_lines));
+    _pending[0] = '\0';
+}
+
+size_t ScrollLog::write(uint8_t c) {
+    if (c == '\r') {
+        return 1;
+    }
+
+    if (c == '\n') {
+        endLine();
+        return 1;
+    }
+
+    // Wrap, like Adafruit_GFX would
+    if (_column >= kScrollLogColumns) {
+        endLine();
+    }
+
+    _pending[_column++] = (char)c;
+    return 1;
+}
+
+void ScrollLog::endLine() {
+    // Whatever was on the screen before (ex. "Waiting for IR Code...") was
+    // drawn at start line 0, without the log's layout.
+    if (!_cleared) {
+        _cleared = true;
+        _display.fillScreen(SSD1306_BLACK);
+    }
+
+    // Replaces the oldest line, once the ring is full
+    uint8_t slot = (_lineCount % kScrollLogLines);
+    memcpy(_lines[slot], _pending, _column);
+    _lines[slot][_column] = '\0';
+    drawLine(slot);
+
+    _lineCount++;
+    _column = 0;
+}
+
+void ScrollLog::drawLine(uint8_t slot) {
+    int16_t y = slot * 8;
+    const char *text = _lines[slot];
+
+    // A known label is copied in already drawn, and only what follows it
+    // needs Adafruit_GFX
+    uint8_t skip = (_labels != NULL) ? _labels->draw(text, slot) : 0;
+    int16_t x    = skip * 6;
+
+    // Only the pixels that change get marked dirty, so re-drawing the same
+    // text costs nothing to send.
+    _display.fillRect(x, y, _display.width() - x, 8, SSD1306_BLACK);
+    _display.setTextSize(1);
+    _display.setTextWrap(false);
+    _display.setTextColor(SSD1306_WHITE);
+    _display.setCursor(x, y);
+    _display.print(&text[skip]);
+}
+
+uint8_t ScrollLog::startLine() const {
+    // Until the screen is full, lines are simply top to bottom
+    if (_lineCount <= kScrollLogLines) {
+        return 0;
+    }
+    return (_lineCount % kScrollLogLines) * 8;
+}
+
+void ScrollLog::show() {
+    _display.setStartLine(startLine());
+}
+
+void ScrollLog::clear() {
+    memset(_lines, 0, sizeof(_lines));
+    _pending[0] = '\0';
+    _column    = 0;
+    _lineCount = 0;
+    _cleared   = true;
+
+    _display.fillScreen(SSD1306_BLACK);
+    _display.setStartLine(0);
+}
+
+void ScrollLog::redraw() {
+    for (uint8_t slot = 0; slot < kScrollLogLines; slot++) {
+        drawLine(slot);
+    }
+}
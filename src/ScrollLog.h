@@ -0,0 +1,70 @@
+/*
+    ScrollLog
+
+    A scrolling text log for the OLED, so every code of a multi-code button
+    press stays on screen (the XR2 "All Power" button sends 3) instead of the
+    later ones being drawn off the bottom.
+
+    Print to it like any other Print.  Each '\n' finishes a line, and lines
+    longer than the screen is wide are wrapped.  The lines are kept in a ring
+    of fixed size text lines, one per 8 pixel page of the screen: line n
+    always lives in page (n % 8) of the framebuffer.  Instead of moving all
+    the pixels up, the SSD1306's display start line register is pointed at
+    the page after the newest line, so the oldest line shows at the top.
+
+    So adding a line is one line of text rasterized, one page sent over I2C
+    and one command to scroll, rather than a fillScreen() and a redraw of
+    everything.
+
+    Nothing is sent to the panel here, that's left to DisplayLayer's
+    flushStep() (or flushDirty()), which sends the scroll after the pixels.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "DisplayLayer.h"
+#include "LabelCache.h"
+
+// 6x8 pixel characters (TEXT_SIZE_SMALL), 128x64 screen
+const uint8_t kScrollLogColumns = 21;
+const uint8_t kScrollLogLines   = 8;
+
+class ScrollLog : public Print {
+public:
+    explicit ScrollLog(DisplayLayer &display);
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Scroll so the newest line is at the bottom (once flushed).
+    void show();
+
+    // Empty the log and the screen (at start line 0).
+    void clear();
+
+    // Re-draw every line into the framebuffer, ex. after something else has
+    // drawn over the screen.  Still needs a show().
+    void redraw();
+
+    uint32_t lineCount() const { return _lineCount; }
+
+    // Lines starting with one of these labels get it copied in pre-drawn,
+    // see LabelCache.h.  NULL to draw everything.
+    void setLabelCache(LabelCache *labels) { _labels = labels; }
+
+private:
+    // Finish the line being built, and draw it into its page.
+    void endLine();
+    void drawLine(uint8_t slot);
+
+    // Start line (in pixel rows) that puts the oldest line at the top
+    uint8_t startLine() const;
+
+    DisplayLayer &_display;
+    LabelCache *_labels;
+    char     _lines[kScrollLogLines][kScrollLogColumns + 1];
+    char     _pending[kScrollLogColumns + 1];  // The line being built
+    uint8_t  _column;     // Characters in _pending
+    uint32_t _lineCount;  // Lines ever finished, the next one is slot % 8
+    bool     _cleared;    // Screen has been cleared for the log yet?
+};
@@ -0,0 +1,83 @@
+/*
+    SerialTx
+
+    See SerialTx.h
+*/
+#include "SerialTx.h"
+
+const uint32_t kTxMask = (SERIAL_TX_QUEUE_SIZE - 1);
+
+// How much to push in one go when write() or flush() has to wait.  About
+// half the UART FIFO, so the wait hook gets called often.
+const size_t kTxBlockingChunk = 64;
+
+TxBuffer::TxBuffer(Print &out)
+    : _out(out), _head(0), _tail(0), _stalls(0), _highWater(0),
+      _waitHook(NULL) {
+}
+
+size_t TxBuffer::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t TxBuffer::write(const uint8_t *buffer, size_t size) {
+    size_t written  = 0;
+    bool   counted  = false;
+
+    while (written < size) {
+        size_t space = (SERIAL_TX_QUEUE_SIZE - pending());
+        if (space == 0) {
+            if (!counted) {
+                _stalls++;
+                counted = true;
+            }
+            sendChunk(kTxBlockingChunk);
+            if (_waitHook) {
+                _waitHook();
+            }
+            continue;
+        }
+
+        size_t offset = (_head & kTxMask);
+        size_t chunk  = min(space, (size - written));
+        chunk = min(chunk, (size_t)(SERIAL_TX_QUEUE_SIZE - offset));
+
+        memcpy(&_buffer[offset], &buffer[written], chunk);
+        _head   += chunk;
+        written += chunk;
+    }
+
+    if (pending() > _highWater) {
+        _highWater = pending();
+    }
+    return written;
+}
+
+void TxBuffer::sendChunk(size_t maxBytes) {
+    size_t offset = (_tail & kTxMask);
+    size_t chunk  = min(pending(), maxBytes);
+    chunk = min(chunk, (size_t)(SERIAL_TX_QUEUE_SIZE - offset));
+
+    if (chunk) {
+        _out.write(&_buffer[offset], chunk);
+        _tail += chunk;
+    }
+}
+
+void TxBuffer::drain() {
+    int room = _out.availableForWrite();
+    while ((room > 0) && pending()) {
+        size_t before = pending();
+        sendChunk((size_t)room);
+        room -= (int)(before - pending());
+    }
+}
+
+void TxBuffer::flush() {
+    while (pending()) {
+        sendChunk(kTxBlockingChunk);
+        if (_waitHook) {
+            _waitHook();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*
+    SerialTx
+
+    A software transmit buffer in front of Serial.
+
+    The ESP8266 UART only has a 128 byte hardware FIFO and HardwareSerial
+    has no buffer of its own for sending, so every print() busy-waits once
+    the FIFO is full.  A long dump would then hold up loop() (and the next
+    IRrecv::decode() check) until the last byte is out the door.
+
+    TxBuffer takes everything that's printed into a RAM ring buffer instead,
+    and drain() (called every loop()) moves only as much as the FIFO can
+    take right now into the UART, so it never waits.
+
+    If the ring fills up anyway, write() has no choice but to wait for room.
+    While it waits it keeps calling the wait hook (main.cpp uses that to keep
+    checking for new IR codes), and it counts a stall so it shows up in the
+    stats.
+*/
+#pragma once
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Size of the software TX buffer in bytes.  Power of two.
+#ifndef SERIAL_TX_QUEUE_SIZE
+#define SERIAL_TX_QUEUE_SIZE     4096
+#endif
+
+class TxBuffer : public Print {
+    static_assert((SERIAL_TX_QUEUE_SIZE & (SERIAL_TX_QUEUE_SIZE - 1)) == 0,
+                  "SERIAL_TX_QUEUE_SIZE must be a power of two");
+
+public:
+    explicit TxBuffer(Print &out);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    // Non-blocking: move what the UART can take right now.
+    void drain();
+
+    // Blocking: wait until everything buffered has been sent.
+    void flush() override;
+
+    // Called over and over while write() is waiting for room.
+    void setWaitHook(void (*hook)()) { _waitHook = hook; }
+
+    size_t pending() const { return (size_t)(_head - _tail); }
+
+    // Free running byte counts, ex. to tell when a given byte has been sent
+    uint32_t totalWritten() const { return _head; }
+    uint32_t totalSent() const { return _tail; }
+    static size_t capacity() { return SERIAL_TX_QUEUE_SIZE; }
+
+    uint32_t stalls() const { return _stalls; }
+    size_t highWater() const { return _highWater; }
+
+private:
+    // Send one contiguous chunk of up to maxBytes (may block in the UART).
+    void sendChunk(size_t maxBytes);
+
+    Print   &_out;
+    uint8_t  _buffer[SERIAL_TX_QUEUE_SIZE];
+    uint32_t _head;     // Bytes ever written in, free running
+    uint32_t _tail;     // Bytes ever sent out, free running
+    uint32_t _stalls;   // Times write() had to wait for room
+    size_t   _highWater;
+    void   (*_waitHook)();
+};
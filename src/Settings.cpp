@@ -0,0 +1,156 @@
+/*
+    Settings
+
+    See Settings.h.  Every setting is described once in kSettingInfo, so
+    loading, saving, setting and printing are all the same walk over it.
+*/
+#include "Settings.h"
+#include <IRrecv.h>
+#include <LittleFS.h>
+#include <stddef.h>
+
+static const char kSettingsPath[] = "/settings.txt";
+
+struct SettingInfo {
+    const char *name;
+    uint8_t     offset;    // In Settings
+    uint8_t     size;      // 1 or 2 bytes
+    uint16_t    minValue;
+    uint16_t    maxValue;
+};
+
+#define SETTING(name, field, minValue, maxValue) \
+    { name, offsetof(Settings, field), sizeof(((Settings *)0)->field), \
+      minValue, maxValue }
+
+static const SettingInfo kSettingInfo[] = {
+    SETTING("tolerance", tolerancePercent, 1, 99),
+    // IRrecv clamps anything longer to kMaxTimeoutMs, so it's refused here
+    SETTING("timeout",   timeoutMs,        1, kMaxTimeoutMs),
+    SETTING("unknown",   minUnknownSize,   2, 1000),
+    SETTING("verbosity", verbosity,        kVerbosityBasic, kVerbosityFull),
+    SETTING("gap",       pressGapMs,       0, 5000),
+};
+static const uint8_t kSettingCount =
+    sizeof(kSettingInfo) / sizeof(kSettingInfo[0]);
+
+// Mounted once, CodeLibrary shares it (LittleFS.begin() again is harmless)
+static bool mountFs() {
+    static bool mounted = false;
+    if (!mounted) {
+        mounted = LittleFS.begin();
+    }
+    return mounted;
+}
+
+static uint16_t getValue(const Settings &settings, const SettingInfo &info) {
+    const uint8_t *field = (const uint8_t *)&settings + info.offset;
+    if (info.size == 1) {
+        return *field;
+    }
+    uint16_t value;
+    memcpy(&value, field, sizeof(value));
+    return value;
+}
+
+static void putValue(Settings *settings, const SettingInfo &info,
+                     uint16_t value) {
+    uint8_t *field = (uint8_t *)settings + info.offset;
+    if (info.size == 1) {
+        *field = (uint8_t)value;
+    } else {
+        memcpy(field, &value, sizeof(value));
+    }
+}
+
+bool setSetting(Settings *settings, const char *name, const char *value) {
+    char *end;
+    unsigned long number = strtoul(value, &end, 10);
+    if ((end == value) || (*end != '\0')) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < kSettingCount; i++) {
+        const SettingInfo &info = kSettingInfo[i];
+        if (strcasecmp(name, info.name) != 0) {
+            continue;
+        }
+        if ((number < info.minValue) || (number > info.maxValue)) {
+            return false;
+        }
+        putValue(settings, info, (uint16_t)number);
+        return true;
+    }
+    return false;
+}
+
+bool loadSettings(Settings *settings) {
+    if (!mountFs()) {
+        return false;
+    }
+    File file = LittleFS.open(kSettingsPath, "r");
+    if (!file) {
+        return false;
+    }
+
+    // Ex. "timeout=30", anything else (blank lines, comments) is skipped
+    while (file.available()) {
+        char line[40];
+        size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[length] = '\0';
+        if ((length > 0) && (line[length - 1] == '\r')) {
+            line[length - 1] = '\0';
+        }
+
+        char *equals = strchr(line, '=');
+        if (equals != NULL) {
+            *equals = '\0';
+            setSetting(settings, line, equals + 1);
+        }
+    }
+    file.close();
+    return true;
+}
+
+bool saveSettings(const Settings &settings) {
+    if (!mountFs()) {
+        return false;
+    }
+    File file = LittleFS.open(kSettingsPath, "w");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint8_t i = 0; i < kSettingCount; i++) {
+        char line[40];
+        int length = snprintf(line, sizeof(line), "%s=%u\n",
+                              kSettingInfo[i].name,
+                              (unsigned)getValue(settings, kSettingInfo[i]));
+        ok = ok && (file.write((const uint8_t *)line, length) ==
+                    (size_t)length);
+    }
+    file.close();
+    return ok;
+}
+
+void printSettings(Print &out, const Settings &settings) {
+    out.print(F("[Config]"));
+    for (uint8_t i = 0; i < kSettingCount; i++) {
+        out.print(' ');
+        out.print(kSettingInfo[i].name);
+        out.print('=');
+        out.print((unsigned)getValue(settings, kSettingInfo[i]));
+    }
+    out.print('\n');
+}
+
+void printSettingNames(Print &out) {
+    for (uint8_t i = 0; i < kSettingCount; i++) {
+        const SettingInfo &info = kSettingInfo[i];
+        char line[48];
+        snprintf(line, sizeof(line), "[Config]   %s (%u-%u)\n", info.name,
+                 (unsigned)info.minValue, (unsigned)info.maxValue);
+        out.print(line);
+    }
+}
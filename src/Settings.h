@@ -0,0 +1,56 @@
+/*
+    Settings
+
+    The capture settings that used to need a rebuild to change, kept in
+    LittleFS (/settings.txt) so they survive a reboot, and changed at run
+    time from the serial console (see Console.h), ex.
+        set timeout 30
+        set verbosity 1
+        save
+
+    /settings.txt is one "name=value" line per setting, the same names as
+    the console uses, so it can also be written by hand and uploaded from
+    data/ with "pio run -t uploadfs".  Settings that aren't in it (or are out
+    of range) keep their defaults.
+
+    tolerance   % either side of a nominal timing the decoders will accept
+    timeout     ms of silence that ends a frame (the long one, with
+                ADAPTIVE_TIMEOUT), up to kMaxTimeoutMs (130)
+    unknown     fewest marks and spaces an UNKNOWN capture needs to be
+                reported
+    verbosity   how much of the text report is sent, see kVerbosity* below
+    gap         PRESS_GROUP_GAP_MS, see PressGroup.h
+*/
+#pragma once
+
+#include <Arduino.h>
+
+// Settings::verbosity, for OUTPUT_FORMAT_TEXT
+const uint8_t kVerbosityBasic = 0;  // Protocol, code, address, command, label
+const uint8_t kVerbosityStats = 1;  // + the Decode/Frame/Queue/TX lines
+const uint8_t kVerbosityFull  = 2;  // + A/C description and rawData[] source
+
+struct Settings {
+    uint8_t  tolerancePercent;
+    uint8_t  timeoutMs;
+    uint16_t minUnknownSize;
+    uint8_t  verbosity;
+    uint16_t pressGapMs;
+};
+
+// Read /settings.txt over the top of settings.  False if there isn't one
+// (or no filesystem), settings are left as they were.
+bool loadSettings(Settings *settings);
+
+// Write all of them to /settings.txt
+bool saveSettings(const Settings &settings);
+
+// Change one by name, ex. ("timeout", "30").  False if there's no such
+// setting or the value is out of its range.
+bool setSetting(Settings *settings, const char *name, const char *value);
+
+// Ex. "[Config] tolerance=25 timeout=90 unknown=12 verbosity=2 gap=200"
+void printSettings(Print &out, const Settings &settings);
+
+// The names and ranges, ex. "timeout (1-130)", one per line
+void printSettingNames(Print &out);
@@ -0,0 +1,205 @@
+/*
+    SignatureIndex
+
+    See SignatureIndex.h
+*/
+#include "SignatureIndex.h"
+#include <IRutils.h>
+#include "RawReplay.h"
+
+// Full decodes that have to agree before an entry is used
+const uint8_t kSignatureConfirmations = 2;
+
+// A template span this long only says "at least 5.1 ms"
+const uint8_t kLongSpan = UINT8_MAX;
+
+static uint8_t binOf(uint16_t ticks) {
+    uint32_t usecs = (uint32_t)ticks * kRawTick;
+    return (uint8_t)min((usecs + (SIGNATURE_KEY_BIN_US / 2)) /
+                        SIGNATURE_KEY_BIN_US, (uint32_t)UINT8_MAX);
+}
+
+SignatureIndex::SignatureIndex()
+    : _hits(0), _misses(0), _checked(0), _wrong(0) {
+    memset(_entries, 0, sizeof(_entries));
+}
+
+uint32_t SignatureIndex::keyOf(const volatile uint16_t *rawTicks,
+                               uint16_t rawLen) {
+    // Entry 0 is the gap before the frame, 1 and 2 the header
+    return ((uint32_t)rawLen << 16) | ((uint32_t)binOf(rawTicks[1]) << 8) |
+           binOf(rawTicks[2]);
+}
+
+uint8_t SignatureIndex::spanOf(uint16_t ticks) {
+    uint32_t usecs = (uint32_t)ticks * kRawTick;
+    return (uint8_t)min((usecs + (SIGNATURE_TICK_US / 2)) / SIGNATURE_TICK_US,
+                        (uint32_t)kLongSpan);
+}
+
+bool SignatureIndex::fits(const SignatureEntry &entry,
+                          const volatile uint16_t *rawTicks, uint16_t rawLen) {
+    for (uint16_t i = 1; i < rawLen; i++) {
+        uint32_t measured = (uint32_t)rawTicks[i] * kRawTick;
+        uint8_t  span     = entry.span[i - 1];
+        if (span == kLongSpan) {
+            if (spanOf(rawTicks[i]) != kLongSpan) {
+                return false;
+            }
+            continue;
+        }
+
+        // Same bounds as IRrecv's ticksLow() / ticksHigh(), around the
+        // template rather than a nominal length
+        uint32_t desired = (uint32_t)span * SIGNATURE_TICK_US;
+        uint32_t margin  = ((desired * SIGNATURE_TOLERANCE) / 100) +
+                           SIGNATURE_TOLERANCE_US;
+        uint32_t low     = (desired > margin) ? (desired - margin) : 0;
+        if ((measured < low) || (measured > (desired + margin + 1))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SignatureIndex::learnable(const decode_results &results) {
+    return (results.decode_type > UNKNOWN) && !results.repeat &&
+           !results.overflow && !hasACState(results.decode_type) &&
+           (results.rawlen > 2) &&
+           (results.rawlen <= SIGNATURE_TEMPLATE_ENTRIES + 1);
+}
+
+SignatureEntry *SignatureIndex::find(const volatile uint16_t *rawTicks,
+                                     uint16_t rawLen) {
+    uint32_t key = keyOf(rawTicks, rawLen);
+    for (uint8_t i = 0; i < kSlots; i++) {
+        SignatureEntry &entry = _entries[i];
+        if (entry.used && (entry.key == key) &&
+            fits(entry, rawTicks, rawLen)) {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+
+bool SignatureIndex::match(const volatile uint16_t *rawTicks, uint16_t rawLen,
+                           bool overflow, decode_results *results) {
+    SignatureEntry *entry = NULL;
+    if (!overflow && (rawLen > 2) &&
+        (rawLen <= SIGNATURE_TEMPLATE_ENTRIES + 1)) {
+        entry = find(rawTicks, rawLen);
+    }
+    if ((entry == NULL) || entry->ambiguous ||
+        (entry->confirmed < kSignatureConfirmations)) {
+        _misses++;
+        return false;
+    }
+
+#if SIGNATURE_VERIFY_EVERY
+    // Now and then, let the full decode have it, to check (see learn())
+    if (++entry->hits >= SIGNATURE_VERIFY_EVERY) {
+        entry->hits = 0;
+        _checked++;
+        return false;
+    }
+#endif  // SIGNATURE_VERIFY_EVERY
+
+    results->decode_type = (decode_type_t)entry->decodeType;
+    results->value       = entry->value;
+    results->address     = entry->address;
+    results->command     = entry->command;
+    results->bits        = entry->bits;
+    results->rawbuf      = const_cast<volatile uint16_t *>(rawTicks);
+    results->rawlen      = rawLen;
+    results->overflow    = false;
+    results->repeat      = false;
+    _hits++;
+    return true;
+}
+
+bool SignatureIndex::matchReceiver(decode_results *results) {
+    volatile irparams_t &params = _IRrecv::params;
+    if (params.rcvstate != kStopState) {
+        return false;  // Nothing finished to look at, and not a miss either
+    }
+    return match(params.rawbuf, params.rawlen, params.overflow, results);
+}
+
+void SignatureIndex::learn(const decode_results &results) {
+    if (!learnable(results)) {
+        return;
+    }
+
+    SignatureEntry *entry = find(results.rawbuf, results.rawlen);
+    if (entry != NULL) {
+        if (entry->ambiguous) {
+            return;
+        }
+        if ((entry->decodeType != (int16_t)results.decode_type) ||
+            (entry->value != results.value) ||
+            (entry->bits != results.bits)) {
+            // Two codes fit the same template, so it can't be trusted
+            entry->ambiguous = true;
+            _wrong++;
+            return;
+        }
+        if (entry->confirmed < UINT8_MAX) {
+            entry->confirmed++;
+        }
+        return;
+    }
+
+    // A free slot, or else the one that's been confirmed least
+    entry = &_entries[0];
+    for (uint8_t i = 0; i < kSlots; i++) {
+        if (!_entries[i].used) {
+            entry = &_entries[i];
+            break;
+        }
+        if (_entries[i].confirmed < entry->confirmed) {
+            entry = &_entries[i];
+        }
+    }
+
+    entry->key        = keyOf(results.rawbuf, results.rawlen);
+    entry->value      = results.value;
+    entry->address    = results.address;
+    entry->command    = results.command;
+    entry->decodeType = (int16_t)results.decode_type;
+    entry->bits       = results.bits;
+    entry->hits       = 0;
+    entry->confirmed  = 1;
+    entry->ambiguous  = false;
+    entry->used       = true;
+    for (uint16_t i = 1; i < results.rawlen; i++) {
+        entry->span[i - 1] = spanOf(results.rawbuf[i]);
+    }
+}
+
+void SignatureIndex::print(Print &out) const {
+    uint8_t  codes = 0;
+    for (uint8_t i = 0; i < kSlots; i++) {
+        const SignatureEntry &entry = _entries[i];
+        if (entry.used && !entry.ambiguous &&
+            (entry.confirmed >= kSignatureConfirmations)) {
+            codes++;
+        }
+    }
+
+    uint32_t total   = _hits + _misses;
+    uint32_t percent = (total > 0) ? (uint32_t)(((uint64_t)_hits * 100) /
+                                                total) : 0;
+
+    // Formatted here rather than with out.printf(), see StageStats::print()
+    char line[112];
+    snprintf(line, sizeof(line),
+        "[Signature] %u hits, %u misses (%u%%), %u checked, %u wrong, "
+        "%u codes\n",
+        (unsigned)_hits,
+        (unsigned)_misses,
+        (unsigned)percent,
+        (unsigned)_checked,
+        (unsigned)_wrong,
+        (unsigned)codes);
+    out.print(line);
+}
@@ -0,0 +1,153 @@
+/*
+    SignatureIndex
+
+    Nearly everything this receiver sees is the same few dozen buttons, and
+    every one of them goes through decode()'s whole protocol sweep, which
+    tries each compiled in decoder in turn until one fits (or none do).
+
+    This remembers the raw timings of codes that have been decoded.  Real
+    captures of one button are never quite the same twice (a mark can come
+    out 40 us longer on one press than the next), so they're not looked up
+    by an exact hash of the timings.  Instead:
+        - the key is coarse: the number of entries, and the header mark and
+          space rounded to SIGNATURE_KEY_BIN_US.  That only narrows it down
+          to the few entries worth looking at.
+        - each entry keeps a template of the frame, every mark and space in
+          SIGNATURE_TICK_US units (one byte each, up to
+          SIGNATURE_TEMPLATE_ENTRIES of them, longer frames aren't learned).
+          A capture only matches if every mark and space is within the
+          tolerance of the template's, the same way the decoders'
+          matchMark() / matchSpace() check a nominal length: within
+          SIGNATURE_TOLERANCE percent, plus SIGNATURE_TOLERANCE_US either way
+          for jitter and the rounding.
+    match() does that for a new capture, before decode(), and if it's a
+    known code fills in the decode_results straight away (decode_type,
+    value, address, command, bits), with no decoders run at all.  Anything
+    else is a miss, and goes through decode() as usual; learn() is then
+    given what that decoded to.
+
+    The tolerance is a lot tighter than the decoders' 25%, because the
+    template is a measurement of the same code, not a protocol's nominal
+    length, and because codes can be close: XMP's nibbles are spaces only
+    137 us apart.  Even so, two different codes could match the same
+    template, and then a hit would be the wrong code.  So:
+        - an entry is only used once the full decode has given the same code
+          for it twice
+        - a template that's decoded to two different codes is marked
+          ambiguous, and never used again
+        - every SIGNATURE_VERIFY_EVERY'th hit on an entry is turned into a
+          miss on purpose, so the full decode checks it still agrees
+
+    Only a header bin edge (ex. a 4500 us space measured as 4740 one time and
+    4760 the next) gives two keys for the same code, which just means it's
+    learned twice.
+
+    Whether this pays off depends on how steady real remotes are, which
+    hasn't been measured on hardware yet, so it's off unless SIGNATURE_INDEX
+    is set (see Config.h).
+
+    Only protocols with a value are learned: A/C (state[]) ones are too long
+    to be worth it, repeats have nothing to learn, and UNKNOWN is noise.
+
+    The "[Signature]" line shows whether it pays off, ex.
+        [Signature] 812 hits, 64 misses (93%), 50 checked, 0 wrong, 18 codes
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+#include "Config.h"
+
+// The header mark and space are rounded to this for the key (us)
+#ifndef SIGNATURE_KEY_BIN_US
+#define SIGNATURE_KEY_BIN_US  500
+#endif
+
+// Template units (us).  Marks and spaces longer than 255 of these (5.1 ms)
+// are only checked to be that long too, the key has already checked the
+// header.
+#ifndef SIGNATURE_TICK_US
+#define SIGNATURE_TICK_US     20
+#endif
+
+// Longest frame that's learned (marks + spaces).  NEC and Samsung are 67.
+#ifndef SIGNATURE_TEMPLATE_ENTRIES
+#define SIGNATURE_TEMPLATE_ENTRIES 72
+#endif
+
+// How far a capture can be from a template and still match it: this much
+// of the template's length (percent), plus this much either way (us)
+#ifndef SIGNATURE_TOLERANCE
+#define SIGNATURE_TOLERANCE   2
+#endif
+#ifndef SIGNATURE_TOLERANCE_US
+#define SIGNATURE_TOLERANCE_US 50
+#endif
+
+// Hits on one entry between full decodes to check it (0 never checks)
+#ifndef SIGNATURE_VERIFY_EVERY
+#define SIGNATURE_VERIFY_EVERY 16
+#endif
+
+// Codes remembered (up to 255)
+#ifndef SIGNATURE_SLOTS
+#define SIGNATURE_SLOTS       32
+#endif
+
+struct SignatureEntry {
+    uint32_t key;          // See keyOf()
+    uint64_t value;
+    uint32_t address;
+    uint32_t command;
+    int16_t  decodeType;
+    uint16_t bits;
+    uint16_t hits;         // Since the last check, for SIGNATURE_VERIFY_EVERY
+    uint8_t  confirmed;    // Times the full decode has agreed (up to 255)
+    bool     ambiguous;
+    bool     used;
+    uint8_t  span[SIGNATURE_TEMPLATE_ENTRIES]; // rawLen - 1 of them
+};
+
+class SignatureIndex {
+public:
+    SignatureIndex();
+
+    // If the capture (IRrecv's layout: kRawTick units, entry 0 the gap
+    // before) is a known code, fill in results as decode() would and return
+    // true.  results.rawbuf is pointed at rawTicks, so they need to stay
+    // put until results is finished with.
+    bool match(const volatile uint16_t *rawTicks, uint16_t rawLen,
+               bool overflow, decode_results *results);
+
+    // The same on IRrecv's own capture buffer, if it has a finished frame.
+    // On a hit the receiver is left stopped, resume() it once results is
+    // finished with (decode() hasn't been called).
+    bool matchReceiver(decode_results *results);
+
+    // After a miss: what the full decode made of the same capture
+    void learn(const decode_results &results);
+
+    // Ex. "[Signature] 812 hits, 64 misses (93%), 50 checked, 0 wrong,
+    //      18 codes"
+    void print(Print &out) const;
+
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+
+private:
+    static const uint8_t kSlots = SIGNATURE_SLOTS;
+
+    static uint32_t keyOf(const volatile uint16_t *rawTicks, uint16_t rawLen);
+    static uint8_t spanOf(uint16_t ticks);
+    static bool fits(const SignatureEntry &entry,
+                     const volatile uint16_t *rawTicks, uint16_t rawLen);
+    static bool learnable(const decode_results &results);
+
+    SignatureEntry *find(const volatile uint16_t *rawTicks, uint16_t rawLen);
+
+    SignatureEntry _entries[kSlots];
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _checked;     // Hits sent to the full decode on purpose
+    uint32_t _wrong;       // Templates found to match more than one code
+};
@@ -0,0 +1,95 @@
+/*
+    SpscRing
+
+    A fixed capacity, single-producer / single-consumer ring buffer.
+
+    Only the producer ever writes _head and only the consumer ever writes
+    _tail, so no locking is needed as long as there is exactly one of each.
+    On the ESP8266 the "producer" and "consumer" are just different stages of
+    loop() (or an ISR and loop()), but the same code works across two cores
+    / tasks because the index is only published after the slot is written.
+
+    Capacity must be a power of two.  The indexes are free running and only
+    masked when used, so all Capacity slots are usable (no "one empty slot").
+*/
+#pragma once
+
+#include <Arduino.h>
+
+// Make sure slot writes are visible before the index that publishes them.
+#ifndef SPSC_BARRIER
+#define SPSC_BARRIER() __sync_synchronize()
+#endif
+
+template <typename T, uint16_t Capacity>
+class SpscRing {
+    static_assert((Capacity != 0) && ((Capacity & (Capacity - 1)) == 0),
+                  "SpscRing Capacity must be a power of two");
+
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    // -- Producer side --
+
+    bool push(const T &item) {
+        T *slot = reserve();
+        if (slot == NULL) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // Get the next free slot to fill in place, or NULL if full.  Nothing is
+    // visible to the consumer until commit() is called.
+    T *reserve() {
+        if ((uint16_t)(_head - _tail) >= Capacity) {
+            return NULL;
+        }
+        return &_items[_head & (Capacity - 1)];
+    }
+
+    void commit() {
+        SPSC_BARRIER();
+        _head = _head + 1;
+    }
+
+    // -- Consumer side --
+
+    bool pop(T &item) {
+        const T *slot = peek();
+        if (slot == NULL) {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // Look at the oldest item (or the index'th oldest) without removing it.
+    const T *peek(uint16_t index = 0) const {
+        if (index >= size()) {
+            return NULL;
+        }
+        SPSC_BARRIER();
+        return &_items[(_tail + index) & (Capacity - 1)];
+    }
+
+    void release() {
+        SPSC_BARRIER();
+        _tail = _tail + 1;
+    }
+
+    // -- Either side --
+
+    uint16_t size() const { return (uint16_t)(_head - _tail); }
+    bool empty() const { return (size() == 0); }
+    bool full() const { return (size() >= Capacity); }
+    static uint16_t capacity() { return Capacity; }
+
+private:
+    T _items[Capacity];
+    volatile uint16_t _head;
+    volatile uint16_t _tail;
+};
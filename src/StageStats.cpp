@@ -0,0 +1,112 @@
+/*
+    StageStats
+
+    See StageStats.h
+*/
+#include "StageStats.h"
+
+static const char kStageNames[kStageCount][8] PROGMEM = {
+    "latency",
+    "latmax",
+    "decode",
+    "format",
+    "serial",
+    "display",
+};
+
+StageStats::StageStats() {
+    reset();
+}
+
+void StageStats::reset() {
+    memset(_stages, 0, sizeof(_stages));
+    for (uint8_t i = 0; i < kStageCount; i++) {
+        _stages[i].min = UINT32_MAX;
+    }
+}
+
+uint8_t StageStats::bucketFor(uint32_t micros) {
+    if (micros < kLinearBuckets) {
+        return (uint8_t)micros;
+    }
+
+    // Position of the top bit (4 for 16..31, 5 for 32..63, ...), then the
+    // two bits under it pick one of 4 sub buckets.
+    uint8_t octave = 31 - __builtin_clz(micros);
+    uint8_t sub    = (micros >> (octave - 2)) & 0x03;
+    uint16_t index = kLinearBuckets + (octave - 4) * 4 + sub;
+
+    return (index < kBucketCount) ? (uint8_t)index : (kBucketCount - 1);
+}
+
+uint32_t StageStats::bucketTop(uint8_t bucket) {
+    if (bucket < kLinearBuckets) {
+        return bucket;
+    }
+
+    uint8_t octave = 4 + (bucket - kLinearBuckets) / 4;
+    uint8_t sub    = (bucket - kLinearBuckets) % 4;
+
+    // Bucket covers [(4 + sub) << (octave - 2), (5 + sub) << (octave - 2))
+    return ((uint32_t)(5 + sub) << (octave - 2)) - 1;
+}
+
+void StageStats::add(PipelineStage stage, uint32_t micros) {
+    if (stage >= kStageCount) {
+        return;
+    }
+
+    Stage &s = _stages[stage];
+    s.count++;
+    s.sum += micros;
+    s.min = min(s.min, micros);
+    s.max = max(s.max, micros);
+
+    uint16_t &bucket = s.histogram[bucketFor(micros)];
+    if (bucket < UINT16_MAX) {
+        bucket++;
+    }
+}
+
+uint32_t StageStats::percentile(const Stage &stage, uint8_t percent) const {
+    // Rank of the sample we want, rounded up (so p99 of 10 samples is the
+    // 10th, i.e. the max)
+    uint32_t rank = ((uint64_t)stage.count * percent + 99) / 100;
+    uint32_t seen = 0;
+
+    for (uint8_t i = 0; i < kBucketCount; i++) {
+        seen += stage.histogram[i];
+        if (seen >= rank) {
+            // Never report more than was actually seen
+            return min(bucketTop(i), stage.max);
+        }
+    }
+    return stage.max;
+}
+
+void StageStats::print(Print &out) const {
+    for (uint8_t i = 0; i < kStageCount; i++) {
+        const Stage &s = _stages[i];
+        if (s.count == 0) {
+            continue;
+        }
+
+        // Ex. "[Stats] decode : n=12 min=210 avg=350 max=900 p99=1023 us"
+        char name[sizeof(kStageNames[0])];
+        strncpy_P(name, kStageNames[i], sizeof(name));
+        name[sizeof(name) - 1] = '\0';
+
+        // Formatted here rather than with out.printf(), which may allocate
+        // for lines over 64 characters
+        char line[96];
+        snprintf(line, sizeof(line),
+            "[Stats] %-7s: n=%u min=%u avg=%u max=%u p99=%u us\n",
+            name,
+            (unsigned)s.count,
+            (unsigned)s.min,
+            (unsigned)(s.sum / s.count),
+            (unsigned)s.max,
+            (unsigned)percentile(s, 99));
+        out.print(line);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+    StageStats
+
+    Where does the time go between an IR code arriving and it showing up on
+    Serial and the screen?  Each stage of the pipeline is timed with the CPU
+    cycle counter (ESP.getCycleCount()) and added here, and print() gives a
+    "[Stats]" line per stage with count/min/avg/max/p99 in microseconds.
+
+    The stages:
+
+    latency  End of the IR frame (its last edge) to decode() returning it.
+             That's the receiver timeout, plus however long the receiver sat
+             "done" before loop() got round to calling decode(), plus the
+             decode itself.  This is the one that shows a code being held up
+             behind a slow Serial dump.  Only EdgeCapture (several receivers,
+             or FRAME_TIMING) knows when the last edge was, so only it gives
+             this one.
+    latmax   The same, with IRrecv on its own.  It doesn't keep the time of
+             the last edge, only that the frame was done at some point since
+             captureStage() last looked, so this is the most it could have
+             been: the timeout, plus all of the time since the last look,
+             plus the decode.  The real latency is between that and just the
+             timeout plus the decode.
+    decode   The successful decode() call on its own.
+    format   Building the report into the TX buffer (printResults()).
+    serial   From starting the report to its last byte leaving the UART.
+    display  displayResults() drawing into the framebuffer.  The I2C transfer
+             is done a chunk per loop() afterwards (DisplayLayer::flushStep()).
+
+    p99 comes from a small log-scale histogram (4 buckets per power of two),
+    so it's reported as the top of the bucket it falls in, within 25%.  Min,
+    max and avg are exact.  Everything is since the last reset(), which
+    main.cpp does after each periodic print, so it's a rolling window (the
+    console's "stats" command prints the window so far, without a reset).
+*/
+#pragma once
+
+#include <Arduino.h>
+
+enum PipelineStage {
+    kStageLatency = 0,
+    kStageLatencyMax,
+    kStageDecode,
+    kStageFormat,
+    kStageSerial,
+    kStageDisplay,
+    kStageCount
+};
+
+// Cycle counts to microseconds at the current CPU speed (80 or 160 MHz)
+inline uint32_t cyclesToMicros(uint32_t cycles) {
+    return cycles / ESP.getCpuFreqMHz();
+}
+
+class StageStats {
+public:
+    StageStats();
+
+    void add(PipelineStage stage, uint32_t micros);
+
+    // One "[Stats] ..." line per stage that has samples.
+    void print(Print &out) const;
+
+    void reset();
+
+private:
+    // Values below 16 us get a bucket each, then 4 buckets per power of two
+    // up to 2^28 us (~4.5 minutes).
+    static const uint8_t kLinearBuckets = 16;
+    static const uint8_t kBucketCount   = kLinearBuckets + (28 - 4) * 4;
+
+    static uint8_t bucketFor(uint32_t micros);
+    static uint32_t bucketTop(uint8_t bucket);
+
+    struct Stage {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+        uint16_t histogram[kBucketCount];
+    };
+
+    uint32_t percentile(const Stage &stage, uint8_t percent) const;
+
+    Stage _stages[kStageCount];
+};
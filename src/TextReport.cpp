@@ -0,0 +1,167 @@
+/*
+    TextReport
+
+    See TextReport.h.  The formatting below follows IRutils.cpp from
+    IRremoteESP8266 v2.8.x line for line, just without the Strings.
+*/
+#include "TextReport.h"
+#include <IRtext.h>
+#include <IRutils.h>
+
+void printUint64(Print &out, uint64_t value, uint8_t base) {
+    // 64 binary digits is the worst case, plus the '\0'
+    char digits[65];
+    char *ptr = &digits[sizeof(digits) - 1];
+    *ptr = '\0';
+
+    if ((base < 2) || (base > 16)) {
+        base = 10;
+    }
+
+    do {
+        uint8_t c = (uint8_t)(value % base);
+        value /= base;
+        *--ptr = (c < 10) ? (char)('0' + c) : (char)('A' + c - 10);
+    } while (value);
+
+    out.print(ptr);
+}
+
+void printProtocolName(Print &out, decode_type_t protocol, bool isRepeat) {
+    bool found = false;
+
+    // kAllProtocolNamesStr is every protocol name, '\0' separated, in
+    // decode_type_t order.  Same walk as typeToString().
+    if ((protocol != decode_type_t::UNKNOWN) && (protocol <= kLastDecodeType)) {
+        const char *ptr = reinterpret_cast<const char *>(kAllProtocolNamesStr);
+        for (uint16_t i = 0; (i <= protocol) && strlen_P(ptr); i++) {
+            if (i == protocol) {
+                out.print(FPSTR(ptr));
+                found = true;
+                break;
+            }
+            ptr += strlen_P(ptr) + 1;
+        }
+    }
+
+    if (!found) {
+        out.print(F(D_STR_UNKNOWN));
+    }
+
+    if (isRepeat) {
+        out.print(F(" (" D_STR_REPEAT ")"));
+    }
+}
+
+void printResultHex(Print &out, const decode_results &results) {
+    out.print(F("0x"));
+
+    if (hasACState(results.decode_type)) {
+#if DECODE_AC
+        for (uint16_t i = 0; results.bits > i * 8; i++) {
+            if (results.state[i] < 0x10) {
+                out.print('0'); // Zero pad
+            }
+            printUint64(out, results.state[i], 16);
+        }
+#endif  // DECODE_AC
+    } else {
+        printUint64(out, results.value, 16);
+    }
+}
+
+void printHumanReadableBasic(Print &out, const decode_results &results) {
+    // Show Encoding standard
+    out.print(F(D_STR_PROTOCOL "  : "));
+    printProtocolName(out, results.decode_type, results.repeat);
+    out.print('\n');
+
+    // Show Code & length
+    out.print(F(D_STR_CODE "      : "));
+    printResultHex(out, results);
+    out.print(F(" ("));
+    printUint64(out, results.bits);
+    out.print(F(" " D_STR_BITS ")\n"));
+}
+
+void printSourceCode(Print &out, const decode_results &results) {
+    // Start declaration
+    out.print(F("uint16_t rawData["));
+    printUint64(out, getCorrectedRawLength(&results));
+    out.print(F("] = {"));
+
+    // Dump data
+    for (uint16_t i = 1; i < results.rawlen; i++) {
+        uint32_t usecs;
+        for (usecs = results.rawbuf[i] * kRawTick; usecs > UINT16_MAX;
+             usecs -= UINT16_MAX) {
+            printUint64(out, UINT16_MAX);
+            if (i % 2) {
+                out.print(F(", 0,  "));
+            } else {
+                out.print(F(",  0, "));
+            }
+        }
+        printUint64(out, usecs);
+        if (i < results.rawlen - 1) {
+            out.print(F(", ")); // ',' not needed on the last one
+        }
+        if (i % 2 == 0) {
+            out.print(' ');     // Extra if it was even.
+        }
+    }
+
+    // End declaration
+    out.print(F("};"));
+
+    // Comment
+    out.print(F("  // "));
+    printProtocolName(out, results.decode_type, results.repeat);
+    // Only display the value if the decode type doesn't have an A/C state.
+    if (!hasACState(results.decode_type)) {
+        out.print(' ');
+        printUint64(out, results.value, 16);
+    }
+    out.print(F("\n"));
+
+    // Now dump "known" codes
+    if (results.decode_type != UNKNOWN) {
+        if (hasACState(results.decode_type)) {
+#if DECODE_AC
+            uint16_t nbytes = results.bits / 8;
+            out.print(F("uint8_t state["));
+            printUint64(out, nbytes);
+            out.print(F("] = {"));
+            for (uint16_t i = 0; i < nbytes; i++) {
+                out.print(F("0x"));
+                if (results.state[i] < 0x10) {
+                    out.print('0');
+                }
+                printUint64(out, results.state[i], 16);
+                if (i < nbytes - 1) {
+                    out.print(F(", "));
+                }
+            }
+            out.print(F("};\n"));
+#endif  // DECODE_AC
+        } else {
+            // Simple protocols
+            // Some protocols have an address &/or command.
+            // NOTE: It will ignore the atypical case when a message has been
+            // decoded but the address & the command are both 0.
+            if ((results.address > 0) || (results.command > 0)) {
+                out.print(F("uint32_t address = 0x"));
+                printUint64(out, results.address, 16);
+                out.print(F(";\n"));
+                out.print(F("uint32_t command = 0x"));
+                printUint64(out, results.command, 16);
+                out.print(F(";\n"));
+            }
+
+            // Most protocols have data
+            out.print(F("uint64_t data = 0x"));
+            printUint64(out, results.value, 16);
+            out.print(F(";\n"));
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+    TextReport
+
+    Heap free versions of the IRremoteESP8266 IRutils text helpers.  They
+    write straight to a Print (normally a ReportWriter) instead of returning
+    a String, and produce the same text as the library functions they
+    replace, so the serial output that gets copied into spreadsheets doesn't
+    change:
+
+        printProtocolName()         typeToString()
+        printResultHex()            resultToHexidecimal()
+        printHumanReadableBasic()   resultToHumanReadableBasic()
+        printSourceCode()           resultToSourceCode()
+*/
+#pragma once
+
+#include <Arduino.h>
+#include <IRrecv.h>
+
+// Ex. "NEC", "XMP", "UNKNOWN", "NEC (Repeat)"
+void printProtocolName(Print &out, decode_type_t protocol,
+                       bool isRepeat = false);
+
+// Ex. "0x20DF40BF", or the state bytes for A/C protocols
+void printResultHex(Print &out, const decode_results &results);
+
+// Ex. "Protocol  : NEC\nCode      : 0x20DF40BF (32 Bits)\n"
+void printHumanReadableBasic(Print &out, const decode_results &results);
+
+// Ex. "uint16_t rawData[71] = {9024, 4460,  ...};  // NEC 20DF40BF\n..."
+void printSourceCode(Print &out, const decode_results &results);
+
+// Same digits as IRremoteESP8266's uint64ToString() (upper case hex)
+void printUint64(Print &out, uint64_t value, uint8_t base = 10);
@@ -0,0 +1,33 @@
+/*
+    Varint
+
+    LEB128 style variable length integers (7 bits per byte, high bit set on
+    every byte except the last) and zigzag mapping of signed values, so small
+    positive or negative numbers both end up as one byte.
+*/
+#pragma once
+
+#include <Arduino.h>
+
+inline uint32_t zigzagEncode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t zigzagDecode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Returns the number of bytes written (1 .. 10)
+inline size_t writeVarint(Print &out, uint64_t value) {
+    size_t count = 0;
+    do {
+        uint8_t b = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if (value) {
+            b |= 0x80;
+        }
+        out.write(b);
+        count++;
+    } while (value);
+    return count;
+}
@@ -52,8 +52,61 @@ SOFTWARE.
 #include <IRremoteESP8266.h>
 #include <IRrecv.h>
 #include <IRac.h>
+#include <IRutils.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "Config.h"
+#include "DisplayLayer.h"
+#include "ScrollLog.h"
+#include "LabelCache.h"
+#include "CaptureQueue.h"
+#include "ReportWriter.h"
+#include "TextReport.h"
+#include "BinaryReport.h"
+#include "SerialTx.h"
+#include "AdaptiveTimeout.h"
+#include "StageStats.h"
+#include "RawReplay.h"
+#if EDGE_CAPTURE
+#include "EdgeCapture.h"
+#endif  // EDGE_CAPTURE
+#include "RepeatCache.h"
+#include "PressGroup.h"
+#include "Settings.h"
+#if HEAP_STATS
+#include "HeapStats.h"
+#endif  // HEAP_STATS
+#if SELF_TEST
+#include <IRsend.h>
+#include "LoopbackTest.h"
+#endif  // SELF_TEST
+#if CONSOLE
+#include "Console.h"
+#endif  // CONSOLE
+#if RAW_FILTER
+#include "RawFilter.h"
+#endif  // RAW_FILTER
+#if SIGNATURE_INDEX
+#include "SignatureIndex.h"
+#endif  // SIGNATURE_INDEX
+#if FRAME_TIMING || JITTER_HISTOGRAM
+#include "FrameTiming.h"
+#endif  // FRAME_TIMING || JITTER_HISTOGRAM
+#if CARRIER_METER
+#include "CarrierMeter.h"
+#endif  // CARRIER_METER
+#if CODE_LIBRARY
+#include "CodeLibrary.h"
+#endif  // CODE_LIBRARY
+#if NET_SINK
+#include "NetSink.h"
+#endif  // NET_SINK
+#if IDLE_SLEEP
+#include "IdleSleep.h"
+#endif  // IDLE_SLEEP
+#if BENCHMARK_MODE
+#include "BenchCorpus.h"
+#endif  // BENCHMARK_MODE
 
 // Reset pin not used but needed for library
 #define OLED_RESET       -1
@@ -69,55 +122,90 @@ SOFTWARE.
 #define TEXT_SIZE_XLARGE  4
 
 /*
-    HACK:
-    The SSD1306 128x64 screen is only 8 lines tall at TEXT_SIZE_SMALL size
-    and if more than 2 IR codes are received, additional codes will bleed
-    off the bottom of the display (no built-in scrolling capabilities)
-
-    The 'hack' here is to clear the screen each time codes are to be shown, but
-    still show all that were returned for one button press.
-
-    Loop() checks IRrecv.decode() each loop, and to prevent a second IR code
-    from causing the display to clear, we use the following variables and
-    constant to give a little grace time and allow multiple codes per button
-    press to be shown.  This is the case for remotes like the Comcast or Xfinity
-    XR2 remotes that may send multiple IR codes (Both NEC and XMP).
-    
-    NOTE: The XFinity XR2 actually emits 3 IR Codes for the "All Power" button.
-    No special case in this code to handle that. It just shows up as partial
-    output.
-
-    Once the CLEAR_AFTER_MILLISECONDS time has elapsed, the next button press
-    (and thus new IR code(s) are received), the display will be cleared and
-    results will be shown.  This saves on having to have a reset button.
-
-    Press quick enough (before CLEAR_AFTER_MILLISECONDS elapses), and you can
-    see the behavior of multiple codes being lost off the bottom of the screen.
-
-    As a visual, a little 2x2 square is drawn in the lower-right corner of the
-    screen after CLEAR_AFTER_MILLISECONDS has passed which means pressing a
-    button on the remote will cause the screen to be cleared first.  Pressing
-    a button before this square is shown, means new code(s) will likely be drawn
-    off the bottom of the screen.
-
-    Yes, quite a hack, but this entire thing is only used to gather and test
-    codes for more _important_ projects that emit them :o)
+    The SSD1306 128x64 screen is only 8 lines tall at TEXT_SIZE_SMALL size,
+    and remotes like the Comcast or Xfinity XR2 send several IR codes for one
+    button press (both NEC and XMP, and 3 codes for "All Power").
+
+    This used to be handled with a 'hack' that cleared the screen when a new
+    press came in, which meant the third code was drawn off the bottom.  Now
+    the results go into a ScrollLog, which scrolls the screen up a line at a
+    time (using the SSD1306's start line register, so it's one page sent per
+    line), and the newest 8 lines are always visible.
 */
-unsigned long g_previousDisplayMillis = 0; // Time button last pressed
 unsigned long g_currentMillis         = 0; // Each loop sets with millis();
-#define CLEAR_AFTER_MILLISECONDS      2000 // Clear when diff is > than this
 
-// Init the display object with the specs
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, NULL, OLED_RESET);
-
-// IR on GPIO pin 14 (D5 on ESP8266)
-const uint16_t kRecvPin = 14;
+// Init the display object with the specs.  DisplayLayer is an Adafruit_SSD1306
+// that only sends the parts of the screen that changed (see DisplayLayer.h).
+DisplayLayer display(SCREEN_WIDTH, SCREEN_HEIGHT, NULL, OLED_RESET);
+
+// The scrolling text log of results on the display (see ScrollLog.h)
+ScrollLog g_scrollLog(display);
+
+// The fixed labels of displayResults(), drawn once in setup() and copied in
+// from then on (see LabelCache.h)
+LabelCache g_labelCache(display);
+
+static const char kLabelProtocol[] PROGMEM = "Protocol: ";
+static const char kLabelCode[]     PROGMEM = "Code    : ";
+static const char kLabelAddress[]  PROGMEM = "Address : ";
+static const char kLabelCommand[]  PROGMEM = "Command : ";
+
+// IR on GPIO pin 14 (D5 on ESP8266).  More receivers can be added with
+// IR_RECEIVER_PINS and IR_RECEIVER_COUNT in Config.h; kRecvPin is the first.
+constexpr uint8_t kRecvPins[] = { IR_RECEIVER_PINS };
+const uint16_t    kRecvPin    = kRecvPins[0];
+static_assert((sizeof(kRecvPins) / sizeof(kRecvPins[0])) == IR_RECEIVER_COUNT,
+              "IR_RECEIVER_PINS must list IR_RECEIVER_COUNT pins");
+
+// For the checks that no two things share a pin
+constexpr bool isReceiverPin(uint8_t pin, uint8_t index = 0) {
+    return (index < IR_RECEIVER_COUNT) &&
+           ((kRecvPins[index] == pin) || isReceiverPin(pin, index + 1));
+}
 
-// The Serial connection baud rate.
-const uint32_t kBaudRate = 115200;
+// The console takes RX (GPIO 3) for itself (see Serial.begin() in setup())
+static_assert(!(CONSOLE && isReceiverPin(3)),
+              "IR_RECEIVER_PINS can't include GPIO 3 (RX) with CONSOLE");
+
+#if SELF_TEST
+// Ex. on the display's SDA the LED would flash with every I2C transfer, and
+// the loopback test would be receiving that as well
+static_assert((IR_SEND_PIN != SDA) && (IR_SEND_PIN != SCL),
+              "IR_SEND_PIN can't be one of the display's I2C pins");
+static_assert(!isReceiverPin(IR_SEND_PIN),
+              "IR_SEND_PIN can't be one of IR_RECEIVER_PINS");
+static_assert(IR_SEND_PIN != CARRIER_PIN,
+              "IR_SEND_PIN can't be CARRIER_PIN");
+#endif  // SELF_TEST
+
+#if CARRIER_METER
+// Its CHANGE interrupt would replace the receiver's (or RX's) on the pin
+static_assert(!isReceiverPin(CARRIER_PIN),
+              "CARRIER_PIN can't be one of IR_RECEIVER_PINS");
+static_assert(!(CONSOLE && (CARRIER_PIN == 3)),
+              "CARRIER_PIN can't be GPIO 3 (RX) with CONSOLE");
+#endif  // CARRIER_METER
+
+// The Serial connection baud rate.  Can be raised with build_flags in
+// platformio.ini, ex. -D SERIAL_BAUD_RATE=921600 (remember monitor_speed too)
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 115200
+#endif
+const uint32_t kBaudRate = SERIAL_BAUD_RATE;
+
+// What gets sent over Serial for each IR code.  TEXT is the BEGIN/END blocks,
+// BINARY is the compact CRC checked framing from BinaryReport.h, which can be
+// turned back into text/CSV with tools/irrecord_binary.py.
+// Pick one with build_flags in platformio.ini, ex. -D OUTPUT_FORMAT=1
+#define OUTPUT_FORMAT_TEXT    0
+#define OUTPUT_FORMAT_BINARY  1
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT         OUTPUT_FORMAT_TEXT
+#endif
 
 // Size of capture buffer.  Tweak if getting mem aloc. error from IRRecv.
-const uint16_t kCaptureBufferSize = 4096;
+// Set by CAPTURE_PROFILE (TV, AC or RAW) in Config.h, or CAPTURE_BUFFER_SIZE.
+const uint16_t kCaptureBufferSize = CAPTURE_BUFFER_SIZE;
 
 // # of ms of 'no-more-data' before we consider a message ended
 const uint8_t kTimeout = 90;
@@ -128,13 +216,317 @@ const uint16_t kMinUnknownSize = 12;
 // kTolerance is defined in IRremoteESP8266\src\IRrecv.h (defaut 25%)
 const uint8_t kTolerancePercentage = kTolerance;
 
-// 4th param causes a buffer of kCaptureBufferSize (uint16_t) to be created and
-// is used for decoding. Tweak kCaptureBufferSize if getting mem aloc. error.
-IRrecv irrecv(kRecvPin, kCaptureBufferSize, kTimeout, true);
+// The above are only the defaults.  What's actually used can be changed from
+// the console (CONSOLE) and kept in /settings.txt, see Settings.h.
+const Settings kDefaultSettings = {
+    kTolerancePercentage,
+    kTimeout,
+    kMinUnknownSize,
+    OUTPUT_VERBOSITY,
+    PRESS_GROUP_GAP_MS,
+};
+Settings g_settings = kDefaultSettings;
+
+// Created by startReceiver().  It's a pointer because the only way to change
+// IRrecv's timeout is to create a new one (see AdaptiveTimeout.h).
+//
+// With more than one receiver (or FRAME_TIMING), IRrecv's own ISR isn't
+// used at all.  The pins are captured by g_edgeCapture and IRrecv only does
+// the decoding.
+IRrecv *irrecv = NULL;
+
+#if EDGE_CAPTURE
+// Capture buffers for all the receivers, split evenly (see EdgeCapture.h)
+uint16_t g_edgePool[kCaptureBufferSize];
+EdgeCapture g_edgeCapture;
+#endif  // EDGE_CAPTURE
+
+#if FRAME_TIMING
+// micros() of the last edge of the previous frame, from any receiver, for
+// the gap between frames.  Only valid once g_haveFrameEnd is set.
+uint32_t g_lastFrameEndMicros = 0;
+bool     g_haveFrameEnd       = false;
+#endif  // FRAME_TIMING
+
+#if JITTER_HISTOGRAM
+// Every decoded mark's error against nominal, since boot (see FrameTiming.h)
+JitterHistogram g_jitterHistogram;
+#endif  // JITTER_HISTOGRAM
+
+#if CARRIER_METER
+// Frequency and duty cycle of each frame's carrier, from the sensor on
+// CARRIER_PIN (see CarrierMeter.h)
+CarrierMeter g_carrierMeter;
+#endif  // CARRIER_METER
+
+// Timeout the current irrecv was created with
+uint8_t g_receiverTimeoutMs = kTimeout;
+
+#if ADAPTIVE_TIMEOUT
+// Learns the shortest safe timeout for the protocols being received
+AdaptiveTimeout g_adaptiveTimeout(kTimeout);
+
+// Only re-create the receiver after this long without any IR codes, so it
+// can't happen in the middle of a multi-code button press.
+const uint32_t kAdaptiveApplyIdleMs = 500;
+
+// millis() of the last code received
+unsigned long g_lastCaptureMillis = 0;
+#endif  // ADAPTIVE_TIMEOUT
 
 // Decoded results from IRrecv::decode()
 decode_results g_DecodeResults;
 
+// Codes waiting to be sent to Serial & the display (see CaptureQueue.h)
+CaptureQueue g_captureQueue;
+
+// Everything printed in loop() goes through here, so printing never has to
+// wait on the UART (see SerialTx.h)
+TxBuffer g_serialTx(Serial);
+
+// Per-stage timing of the capture -> output pipeline (see StageStats.h)
+StageStats g_stageStats;
+
+// Identical codes close together (held buttons) are counted, not output
+RepeatCache g_repeatCache(REPEAT_CACHE_WINDOW_MS);
+
+// The frames of one button press are output together (see PressGroup.h).
+// The benchmark's captures are all separate, with no need to wait.
+PressGroup g_pressGroup(BENCHMARK_MODE ? 0 : g_settings.pressGapMs);
+
+#if RAW_FILTER
+// Glitches merged and noise thrown away before decoding (see RawFilter.h)
+RawFilter g_rawFilter(RAW_FILTER_GLITCH_US, RAW_FILTER_MIN_FIRST_MARK_US);
+#endif  // RAW_FILTER
+
+#if SIGNATURE_INDEX
+// Known codes picked out before the protocol sweep (see SignatureIndex.h)
+SignatureIndex g_signatureIndex;
+#endif  // SIGNATURE_INDEX
+
+#if CODE_LIBRARY
+// Every code seen, and their labels, in LittleFS (see CodeLibrary.h)
+CodeLibrary g_codeLibrary;
+#endif  // CODE_LIBRARY
+
+#if NET_SINK
+// Captures batched into UDP packets for a collector (see NetSink.h)
+NetSink g_netSink;
+
+// While Wi-Fi is down, how often idleStage() lets poll() try again
+const uint32_t kNetRetryMs = 100;
+#endif  // NET_SINK
+
+#if HEAP_STATS
+// Free heap, fragmentation and its slope since boot (see HeapStats.h)
+HeapStats g_heapStats;
+#endif  // HEAP_STATS
+
+#if SELF_TEST
+// Sends known codes at the receiver and checks they come back (see
+// LoopbackTest.h)
+IRsend g_irsend(IR_SEND_PIN);
+LoopbackTest g_loopback(g_irsend);
+#endif  // SELF_TEST
+
+#if IDLE_SLEEP
+// Sleeps loop() while there's nothing to do (see IdleSleep.h)
+IdleSleep g_idleSleep;
+#endif  // IDLE_SLEEP
+
+// ESP.getCycleCount() the last time captureStage() checked the receiver
+uint32_t g_lastPollCycles = 0;
+
+// Waiting for the last byte of a report to leave the TX buffer, to time the
+// "serial" stage.
+bool     g_serialMarkPending = false;
+uint32_t g_serialMarkByte    = 0; // TxBuffer::totalWritten() at end of report
+uint32_t g_serialMarkCycles  = 0; // When the report was started
+
+// millis() of the last periodic stats print
+unsigned long g_previousStatsMillis = 0;
+
+void captureStage();
+void printStats(Print &out, uint32_t windowMs);
+
+/*
+startReceiver
+
+Create (or re-create) the IRrecv object with the given timeout and start it.
+
+3rd param causes a buffer of kCaptureBufferSize (uint16_t) to be created and
+is used for decoding. Tweak kCaptureBufferSize if getting mem aloc. error.
+
+By default (CAPTURE_SAVE_BUFFER 0) there is no save buffer, decode() works
+in place and queueDecoded() calls resume() as soon as the capture queue has
+its own copy.  That halves the RAM IRrecv needs.
+
+With several receivers (or FRAME_TIMING), the IRrecv is only created the
+first time, as a decoder (with a buffer for one receiver's frames), and the
+timeout is just passed on to g_edgeCapture.
+*/
+void startReceiver(uint8_t timeoutMs) {
+#if EDGE_CAPTURE
+    g_receiverTimeoutMs = timeoutMs;
+    if (irrecv != NULL) {
+        g_edgeCapture.setTimeout(timeoutMs);
+        return;
+    }
+
+    irrecv = new IRrecv(kRecvPin, (kCaptureBufferSize / IR_RECEIVER_COUNT) + 1,
+                        timeoutMs, false);
+#if DECODE_HASH
+    irrecv->setUnknownThreshold(g_settings.minUnknownSize);
+#endif  // DECODE_HASH
+    irrecv->setTolerance(g_settings.tolerancePercent);
+
+    g_edgeCapture.begin(kRecvPins, IR_RECEIVER_COUNT, g_edgePool,
+                        kCaptureBufferSize, timeoutMs);
+    return;
+#endif  // EDGE_CAPTURE
+
+    if (irrecv != NULL) {
+        irrecv->disableIRIn();
+        delete irrecv;
+    }
+
+    irrecv = new IRrecv(kRecvPin, kCaptureBufferSize, timeoutMs,
+                        CAPTURE_SAVE_BUFFER);
+    g_receiverTimeoutMs = timeoutMs;
+
+#if DECODE_HASH
+    // Ignore messages with less than minimum on or off pulses.
+    irrecv->setUnknownThreshold(g_settings.minUnknownSize);
+#endif  // DECODE_HASH
+    irrecv->setTolerance(g_settings.tolerancePercent);  // Override the default tolerance.
+    irrecv->enableIRIn();  // Start the receiver
+}
+
+/*
+applySettings
+
+Put g_settings into effect after they've changed (see Settings.h).
+
+The tolerance and UNKNOWN size are set on the receiver straight away.  A new
+timeout means a new receiver (see startReceiver()), which would lose a frame
+that's on its way in, but a console command is never in the middle of a
+button press.  With ADAPTIVE_TIMEOUT it's the long timeout that changes, and
+adaptTimeoutStage() switches to it once things are quiet.
+
+Before the receiver has been started (setup()), only the rest is done.
+*/
+void applySettings() {
+#if ADAPTIVE_TIMEOUT
+    g_adaptiveTimeout.setLongTimeoutMs(g_settings.timeoutMs);
+#endif  // ADAPTIVE_TIMEOUT
+    g_pressGroup.setGapMs(BENCHMARK_MODE ? 0 : g_settings.pressGapMs);
+
+    if (irrecv == NULL) {
+        return;
+    }
+
+#if DECODE_HASH
+    irrecv->setUnknownThreshold(g_settings.minUnknownSize);
+#endif  // DECODE_HASH
+    irrecv->setTolerance(g_settings.tolerancePercent);
+
+#if !ADAPTIVE_TIMEOUT
+    if (g_settings.timeoutMs != g_receiverTimeoutMs) {
+        startReceiver(g_settings.timeoutMs);
+    }
+#endif  // ADAPTIVE_TIMEOUT
+}
+
+#if CONSOLE
+/*
+Console commands
+
+Ex.
+    set verbosity 0
+    [Config] tolerance=25 timeout=90 unknown=12 verbosity=0 gap=200
+*/
+void commandGet(const char *args, Print &out) {
+    (void)args;
+    printSettings(out, g_settings);
+}
+
+void commandSet(const char *args, Print &out) {
+    // Ex. "timeout 30"
+    char name[16];
+    const char *value = strchr(args, ' ');
+    size_t length = (value != NULL) ? (size_t)(value - args) : 0;
+    if ((length == 0) || (length >= sizeof(name))) {
+        out.println(F("[Config] usage: set <name> <value>"));
+        printSettingNames(out);
+        return;
+    }
+    memcpy(name, args, length);
+    name[length] = '\0';
+    while (*value == ' ') {
+        value++;
+    }
+
+    if (!setSetting(&g_settings, name, value)) {
+        out.println(F("[Config] no such setting, or out of range:"));
+        printSettingNames(out);
+        return;
+    }
+    applySettings();
+    printSettings(out, g_settings);
+}
+
+void commandSave(const char *args, Print &out) {
+    (void)args;
+    out.println(saveSettings(g_settings) ? F("[Config] saved")
+                                         : F("[Config] save FAILED"));
+}
+
+void commandLoad(const char *args, Print &out) {
+    (void)args;
+    if (!loadSettings(&g_settings)) {
+        out.println(F("[Config] nothing saved"));
+    }
+    applySettings();
+    printSettings(out, g_settings);
+}
+
+void commandDefaults(const char *args, Print &out) {
+    (void)args;
+    g_settings = kDefaultSettings;
+    applySettings();
+    printSettings(out, g_settings);
+}
+
+void commandStats(const char *args, Print &out) {
+    (void)args;
+    // The window so far, which carries on afterwards
+    printStats(out, g_currentMillis - g_previousStatsMillis);
+}
+
+const ConsoleCommand kConsoleCommands[] = {
+    { "get",      commandGet,      "show the settings" },
+    { "set",      commandSet,      "<name> <value>, change one" },
+    { "save",     commandSave,     "keep them in flash" },
+    { "load",     commandLoad,     "go back to the saved ones" },
+    { "defaults", commandDefaults, "go back to the built in ones" },
+    { "stats",    commandStats,    "print the [Stats] lines now" },
+};
+
+Console g_console(kConsoleCommands,
+                  sizeof(kConsoleCommands) / sizeof(kConsoleCommands[0]));
+
+/*
+consoleStage
+
+Run any commands that have come in on Serial RX (see Console.h).  Replies go
+through the TX buffer like everything else.
+*/
+void consoleStage() {
+    ReportWriter out(g_serialTx);
+    g_console.poll(Serial, out);
+}
+#endif  // CONSOLE
+
 /*
 displayResults
 
@@ -145,47 +537,48 @@ Protocol (XMP, NEC, etc.)
 Code
 Address
 Commmand
+[Label] (if it's in the code library, ex. "[Vizio Vol+]")
 
 Depending on Protocol, some fields may not be shown.
 */
-void displayResults(decode_results ir_results) {
-
-    // Here's the HACK to clear screen if CLEAR_AFTER_MILLISECONDS ellapsed.
-    if ((g_currentMillis-g_previousDisplayMillis) > CLEAR_AFTER_MILLISECONDS) {
-        display.fillScreen(SSD1306_BLACK); // SSD1306_BLACK
-        display.setCursor(0, 0);
+void displayResults(const CaptureRecord &record,
+                    const decode_results &ir_results, const char *label) {
+
+    // Ex. NEC, XMP, SAMSUNG, etc.  With several receivers, ex. "NEC @14"
+    g_scrollLog.print(FPSTR(kLabelProtocol));
+    printProtocolName(g_scrollLog, ir_results.decode_type, ir_results.repeat);
+    if (record.source != kCaptureNoSource) {
+        g_scrollLog.printf(" @%u", (unsigned)record.source);
     }
-
-    display.setTextSize(TEXT_SIZE_SMALL);
-    display.setTextColor(SSD1306_WHITE);
-
-    // Ex. NEC, XMP, SAMSUNG, etc.
-    String protocol = String(typeToString(g_DecodeResults.decode_type,
-        g_DecodeResults.repeat));
-    display.printf("Protocol: %s\n", protocol.c_str());
+    g_scrollLog.print('\n');
 
     // Ex. "Code    : 0x20DF40BF"
-    String code = resultToHexidecimal(&g_DecodeResults);
-    display.printf("Code    : %s\n", code.c_str());
+    g_scrollLog.print(FPSTR(kLabelCode));
+    printResultHex(g_scrollLog, ir_results);
+    g_scrollLog.print('\n');
 
     // Ex. "Address : 0x04FB (4)"
-    if (g_DecodeResults.address > 0) {
-        display.printf("Address : 0x%02X%02X (%d)\n",
-                        g_DecodeResults.address,
-                        (0xFF -g_DecodeResults.address),
-                        g_DecodeResults.address);
+    if (ir_results.address > 0) {
+        g_scrollLog.print(FPSTR(kLabelAddress));
+        g_scrollLog.printf("0x%02X%02X (%d)\n",
+                        ir_results.address,
+                        (0xFF -ir_results.address),
+                        ir_results.address);
     }
 
     // Ex. "Command : 0x02FD (2)"
-    if (g_DecodeResults.command > 0) {
-        display.printf("Command : 0x%02X%02X (%d)\n",
-                        g_DecodeResults.command,
-                        (0xFF -g_DecodeResults.command),
-                        g_DecodeResults.command);
+    if (ir_results.command > 0) {
+        g_scrollLog.print(FPSTR(kLabelCommand));
+        g_scrollLog.printf("0x%02X%02X (%d)\n",
+                        ir_results.command,
+                        (0xFF -ir_results.command),
+                        ir_results.command);
     }
 
-    display.display();
-    g_previousDisplayMillis = millis();
+    // Ex. "[Vizio Vol+]"
+    if (label[0]) {
+        g_scrollLog.printf("[%s]\n", label);
+    }
 }
 
 /*
@@ -195,7 +588,12 @@ Start Serial, set IRRecv object, a display initial "Waiting for IR Code"
 
 */
 void setup() {
+#if CONSOLE
+    // RX too, for the console (see Console.h)
+    Serial.begin(kBaudRate, SERIAL_8N1, SERIAL_FULL);
+#else
     Serial.begin(kBaudRate, SERIAL_8N1, SERIAL_TX_ONLY);
+#endif  // CONSOLE
 
     while (!Serial)  // Wait for the serial connection to be establised.
         delay(50);
@@ -205,12 +603,60 @@ void setup() {
     assert(irutils::lowLevelSanityCheck() == 0);
 
     Serial.printf("\n" D_STR_IRRECVDUMP_STARTUP "\n", kRecvPin);
-#if DECODE_HASH
-    // Ignore messages with less than minimum on or off pulses.
-    irrecv.setUnknownThreshold(kMinUnknownSize);
-#endif  // DECODE_HASH
-    irrecv.setTolerance(kTolerancePercentage);  // Override the default tolerance.
-    irrecv.enableIRIn();  // Start the receiver
+
+#if CONSOLE
+    // Before the receiver is started with them
+    if (loadSettings(&g_settings)) {
+        applySettings();
+    }
+    printSettings(Serial, g_settings);
+#endif  // CONSOLE
+
+    startReceiver(g_settings.timeoutMs);
+
+#if EDGE_CAPTURE
+    // Ex. "Receivers: GPIO 14 12 13 (1365 entries each)"
+    Serial.print(F("Receivers: GPIO"));
+    for (uint8_t i = 0; i < IR_RECEIVER_COUNT; i++) {
+        Serial.printf(" %u", (unsigned)kRecvPins[i]);
+    }
+    Serial.printf(" (%u entries each)\n",
+                  (unsigned)g_edgeCapture.bufferSize());
+#endif  // EDGE_CAPTURE
+
+#if BENCHMARK_MODE
+    // Captures come from BenchCorpus.cpp instead, see benchmarkStage()
+    irrecv->disableIRIn();
+    Serial.printf("[Bench] %u captures per round, corpus of %u\n",
+                  (unsigned)BENCHMARK_CAPTURES, (unsigned)kBenchCorpusSize);
+#endif  // BENCHMARK_MODE
+
+#if CARRIER_METER
+    g_carrierMeter.begin(CARRIER_PIN);
+    Serial.printf("[Carrier] measuring on GPIO %u\n", (unsigned)CARRIER_PIN);
+#endif  // CARRIER_METER
+
+#if SELF_TEST
+    g_loopback.begin();
+    Serial.printf("[Loopback] sending on GPIO %u\n", (unsigned)IR_SEND_PIN);
+#endif  // SELF_TEST
+
+#if NET_SINK
+    // Connects in the background, captures wait in the packet pool until then
+    g_netSink.begin(WIFI_SSID, WIFI_PASSWORD, NET_COLLECTOR_HOST,
+                    NET_COLLECTOR_PORT);
+#endif  // NET_SINK
+
+#if IDLE_SLEEP
+    g_idleSleep.begin(NET_SINK);
+#if EDGE_CAPTURE
+    // The first edge of a frame ends a sleep right away
+    EdgeCapture::setFrameStartHook(IdleSleep::wake);
+#endif  // EDGE_CAPTURE
+#endif  // IDLE_SLEEP
+
+    // Keep checking for IR codes even if printing has to wait for the UART
+    g_serialTx.setWaitHook(captureStage);
 
     if(!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
         Serial.println(F("SSD1306 allocation FAILED"));
@@ -219,19 +665,853 @@ void setup() {
         Serial.println(F("SSD1306 allocation SUCCEEDED"));
     }
 
+#if CODE_LIBRARY
+    if (g_codeLibrary.begin()) {
+        Serial.printf("[Library] %u codes\n", (unsigned)g_codeLibrary.size());
+#if CODE_LIBRARY_EXPORT_AT_BOOT
+        // The whole table, ready to paste into a spreadsheet
+        Serial.println(F("[Library] BEGIN"));
+        g_codeLibrary.exportCsv(Serial);
+        Serial.println(F("[Library] END"));
+#endif  // CODE_LIBRARY_EXPORT_AT_BOOT
+    } else {
+        Serial.println(F("[Library] No filesystem, library disabled"));
+    }
+#endif  // CODE_LIBRARY
+
+    // Before anything is drawn, as it uses the framebuffer to render them
+    g_labelCache.add(kLabelProtocol);
+    g_labelCache.add(kLabelCode);
+    g_labelCache.add(kLabelAddress);
+    g_labelCache.add(kLabelCommand);
+    g_scrollLog.setLabelCache(&g_labelCache);
+
     display.fillScreen(SSD1306_BLACK); // SSD1306_BLACK
     display.setTextSize(TEXT_SIZE_MEDIUM);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
     display.println(F("Waiting\nfor\nIR Code..."));
-    display.display();
+    display.flushDirty();
+}
+
+/*
+releaseCapture
+
+Done with the raw timings in g_DecodeResults (the capture queue has its own
+copy), so hand IRrecv's buffer straight back for the next frame.  The rest
+of g_DecodeResults stays valid.
+
+With EdgeCapture, captureStage() already gave the receiver its buffer back
+before decoding (IRrecv's own buffer is only the decoder's), and with
+CAPTURE_SAVE_BUFFER decode() resumed by itself, so there's nothing to do.
+*/
+void releaseCapture() {
+#if !EDGE_CAPTURE && !CAPTURE_SAVE_BUFFER
+    irrecv->resume();
+#endif  // !EDGE_CAPTURE && !CAPTURE_SAVE_BUFFER
 }
 
+/*
+dropCarrier
+
+For a frame that isn't going to be queued: whatever carrier was measured
+with it is thrown away, so it isn't added to the next frame's.
+*/
+void dropCarrier() {
+#if CARRIER_METER
+    g_carrierMeter.take(NULL);
+#endif  // CARRIER_METER
+}
+
+/*
+queueDecoded
+
+What happens to each code in g_DecodeResults once it's decoded, whichever
+receiver it came from: time it, and queue it for output (unless it's a
+repeat).  latencyStage is kStageLatency when latencyMicros was measured,
+kStageLatencyMax when it's only the most it could have been (see
+StageStats.h).  source is the receiver's GPIO, or kCaptureNoSource, and
+times is NULL unless FRAME_TIMING.
+*/
+void queueDecoded(uint32_t decodeMicros, PipelineStage latencyStage,
+                  uint32_t latencyMicros, uint8_t source,
+                  const FrameTimes *times) {
+    unsigned long now = millis();
+
+    const CarrierReading *carrier = NULL;
+#if CARRIER_METER
+    // Everything measured since the frame before was this one's carrier
+    CarrierReading carrierReading;
+    g_carrierMeter.take(&carrierReading);
+    carrier = &carrierReading;
+#endif  // CARRIER_METER
+
+#if SELF_TEST
+    // Before the repeat check, every code sent is counted
+    g_loopback.received(g_DecodeResults);
+#endif  // SELF_TEST
+
+    // Everything that reads the raw timings goes first...
+#if JITTER_HISTOGRAM
+    // Before the repeat check, a held button is lots of samples
+    g_jitterHistogram.addFrame(g_DecodeResults);
+#endif  // JITTER_HISTOGRAM
+
+#if ADAPTIVE_TIMEOUT
+    g_adaptiveTimeout.learn(g_DecodeResults, now);
+    g_lastCaptureMillis = now;
+#endif  // ADAPTIVE_TIMEOUT
+
+    if (!g_DecodeResults.repeat &&
+        !g_repeatCache.seen(g_DecodeResults, now)) {
+        g_captureQueue.push(g_DecodeResults, now, g_receiverTimeoutMs,
+                            decodeMicros, source, times, carrier);
+    }
+
+    // ...so the receiver can have its buffer back before anything else
+    releaseCapture();
+
+    g_stageStats.add(kStageDecode, decodeMicros);
+    g_stageStats.add(latencyStage, latencyMicros);
+}
+
+/*
+captureStage
+
+Check if an IR code has been received and, if so, copy it into the capture
+queue.  This is kept as short as possible, all of the slow Serial and display
+work is done later by outputStage().
+
+It's also called in between the slower parts of the output, so a code that
+arrives while another is being printed gets picked up right away.
+*/
+void captureStage() {
+#if EDGE_CAPTURE
+    // One frame per call, from the next receiver in turn that has one
+    int8_t receiver = g_edgeCapture.nextFrame();
+    if (receiver < 0) {
+        return;
+    }
+
+    uint16_t length;
+    bool     overflow;
+    uint16_t *ticks = g_edgeCapture.frame(receiver, &length, &overflow);
+    uint32_t frameEndMicros = g_edgeCapture.frameEndMicros(receiver);
+
+#if RAW_FILTER
+    // Noise is dropped here, before the decoders (or the frame timing) see it
+    if (!g_rawFilter.apply(ticks, &length)) {
+        g_edgeCapture.release(receiver);
+        dropCarrier();
+        return;
+    }
+#endif  // RAW_FILTER
+
+    const FrameTimes *times = NULL;
+#if FRAME_TIMING
+    // Ex. the NEC then XMP of one XR2 press: the gap is from the end of the
+    // NEC frame to the start of the XMP one.  Undecoded frames count too,
+    // they were still on the air.
+    FrameTimes frameTimes;
+    frameTimes.startMicros = g_edgeCapture.frameStartMicros(receiver);
+    frameTimes.endMicros   = frameEndMicros;
+    frameTimes.gapMicros   = g_haveFrameEnd
+        ? (frameTimes.startMicros - g_lastFrameEndMicros) : 0;
+    g_lastFrameEndMicros = frameEndMicros;
+    g_haveFrameEnd       = true;
+    times = &frameTimes;
+#endif  // FRAME_TIMING
+
+    uint32_t startCycles = ESP.getCycleCount();
+    bool fastPath = false;
+#if SIGNATURE_INDEX
+    fastPath = g_signatureIndex.match(ticks, length, overflow,
+                                      &g_DecodeResults);
+#endif  // SIGNATURE_INDEX
+    bool decoded = fastPath || replayTicks(*irrecv, ticks, length, overflow,
+                                           &g_DecodeResults);
+    uint32_t decodeMicros = cyclesToMicros(ESP.getCycleCount() - startCycles);
+
+    // IRrecv has its own copy now, so that receiver can start on the next.
+    // A fast path result still points at the frame, so that waits.
+    if (!fastPath) {
+        g_edgeCapture.release(receiver);
+    }
+
+#if SIGNATURE_INDEX
+    if (decoded && !fastPath) {
+        g_signatureIndex.learn(g_DecodeResults);
+    }
+#endif  // SIGNATURE_INDEX
+
+    if (decoded) {
+        // The time of the last edge is known exactly here.  With just the
+        // one receiver (FRAME_TIMING), there's no need to say which.
+        queueDecoded(decodeMicros, kStageLatency, micros() - frameEndMicros,
+                     (IR_RECEIVER_COUNT > 1) ? g_edgeCapture.pin(receiver)
+                                             : kCaptureNoSource,
+                     times);
+    } else {
+        dropCarrier();
+    }
+
+    if (fastPath) {
+        g_edgeCapture.release(receiver);
+    }
+#else
+    uint32_t pollCycles  = ESP.getCycleCount();
+    uint32_t sinceLastPoll = pollCycles - g_lastPollCycles;
+    g_lastPollCycles = pollCycles;
+
+#if RAW_FILTER
+    // Still in the receiver's own buffer, decode() hasn't copied it yet
+    if (!g_rawFilter.applyToReceiver()) {
+        irrecv->resume();
+        dropCarrier();
+        return;
+    }
+#endif  // RAW_FILTER
+
+    // A frame decode() finds nothing in is resumed inside it, so whether
+    // there was one at all has to be looked at first
+    bool finished = (_IRrecv::params.rcvstate == kStopState);
+
+    // After RawFilter, same as the EdgeCapture path
+    uint32_t startCycles = ESP.getCycleCount();
+    bool fastPath = false;
+#if SIGNATURE_INDEX
+    fastPath = g_signatureIndex.matchReceiver(&g_DecodeResults);
+#endif  // SIGNATURE_INDEX
+
+    if (fastPath || irrecv->decode(&g_DecodeResults)) {
+        // How long the protocol decoders took, which depends a lot on which
+        // DECODE_* protocols are compiled in (see platformio.ini)
+        uint32_t doneCycles   = ESP.getCycleCount();
+        uint32_t decodeMicros = cyclesToMicros(doneCycles - startCycles);
+
+#if SIGNATURE_INDEX
+        if (!fastPath) {
+            g_signatureIndex.learn(g_DecodeResults);
+        }
+#endif  // SIGNATURE_INDEX
+
+        // The frame ended a timeout before the receiver flagged it done, and
+        // that happened at some point since the last time we checked, so
+        // this is only an upper bound.  The filter is part of the wait.
+        queueDecoded(decodeMicros, kStageLatencyMax,
+                     (g_receiverTimeoutMs * 1000UL) +
+                     cyclesToMicros(sinceLastPoll + (doneCycles - pollCycles)),
+                     kCaptureNoSource, NULL);
+
+#if CAPTURE_SAVE_BUFFER
+        // decode() would have done this straight after copying the buffer
+        if (fastPath) {
+            irrecv->resume();
+        }
+#endif  // CAPTURE_SAVE_BUFFER
+    } else if (finished) {
+        // Ex. UNKNOWN below minUnknownSize, same as the EdgeCapture path
+        dropCarrier();
+    }
+#endif  // EDGE_CAPTURE
+}
+
+#if ADAPTIVE_TIMEOUT
+/*
+adaptTimeoutStage
+
+If the learned timeout is different from what the receiver is using, and
+it's been quiet for a bit, re-create the receiver with the new timeout.
+*/
+void adaptTimeoutStage() {
+    uint8_t wanted = g_adaptiveTimeout.timeoutMs(g_currentMillis);
+    if ((wanted != g_receiverTimeoutMs) &&
+        ((g_currentMillis - g_lastCaptureMillis) > kAdaptiveApplyIdleMs)) {
+        startReceiver(wanted);
+    }
+}
+#endif  // ADAPTIVE_TIMEOUT
+
+/*
+printResults
+
+Dump everything we know about one IR code to Serial, or as much of it as
+g_settings.verbosity asks for (see Settings.h).
+
+Everything goes through a ReportWriter, which formats into a small fixed
+buffer and passes it on to Serial in chunks, so there are no Strings (and no
+heap allocations) involved for the usual TV/remote protocols.  The only
+exception is the A/C description, which only the library can build, and only
+for protocols IRac actually supports.
+
+pressLeft is how many frames of this press are still queued, this one
+included, so they aren't counted as waiting.
+*/
+void printResults(const CaptureRecord &record,
+                  const decode_results &ir_results, const char *label,
+                  uint8_t pressLeft) {
+    ReportWriter out(g_serialTx);
+
+    // Check if we got an IR message that was to big for our capture buffer.
+    if (ir_results.overflow) {
+        out.printf(D_WARN_BUFFERFULL "\n", kCaptureBufferSize);
+    }
+
+    // Display the tolerance % if it has been changed from the default.
+    if  (g_settings.tolerancePercent != kTolerance) {
+        out.printf(D_STR_TOLERANCE " : %d%%\n", g_settings.tolerancePercent);
+    }
+
+    // Display the basic output of what we found.
+    out.println(F("[resultToHumanReadableBasic]:"));
+    printHumanReadableBasic(out, ir_results);
+    out.flush();
+    captureStage();
+
+    // The two heavy sections, left out below kVerbosityFull
+    if (g_settings.verbosity >= kVerbosityFull) {
+        // Display any extra A/C info if we have it.
+        if (IRac::isProtocolSupported(ir_results.decode_type)) {
+            String description = IRAcUtils::resultAcToString(&ir_results);
+            if (description.length()) {
+                out.println(F("[resultsAcToString]:"));
+                out.print(F(D_STR_MESGDESC ": "));
+                out.println(description);
+            }
+        }
+
+        // Output the results as source code
+        // Same as resultToSourceCode() from ....IRremoteESP8266\src\IRutils.cpp
+        out.println(F("[resultsToSourceCode]:"));
+        printSourceCode(out, ir_results);
+        out.println();
+        out.flush();
+        captureStage();
+    }
+
+    // Ex. "Address: 0x04FB (4)"
+    if (ir_results.address) {
+        out.printf("Address: 0x%02X%02X (%d)\n",
+            ir_results.address,
+            (0xFF - ir_results.address),
+            ir_results.address);
+    }
+
+    // Ex. "Command: 0x02FD (2)"
+    if (ir_results.command) {
+        out.printf("Command: 0x%02X%02X (%d)\n",
+            ir_results.command,
+            (0xFF - ir_results.command),
+            ir_results.command);
+    }
+
+    // Ex. "Value  : 0x0000000020DF40BF"
+    if (ir_results.value) {
+        out.printf("Value  : 0x%08X%08X\n",
+            ( (uint32_t)((ir_results.value >> 32) & 0xFFFFFFFF) ),
+            ( (uint32_t)(ir_results.value & 0xFFFFFFFF))
+        );
+    }
+
+    // Ex. "Source : GPIO 14"
+    if (record.source != kCaptureNoSource) {
+        out.printf("Source : GPIO %u\n", (unsigned)record.source);
+    }
+
+    // Ex. "Label  : Vizio Vol+"
+    if (label[0]) {
+        out.printf("Label  : %s\n", label);
+    }
+
+#if CARRIER_METER
+    // Ex. "Carrier: 37950 Hz, duty 33% (812 cycles)"
+    if (record.carrier.cycles) {
+        out.printf("Carrier: %u Hz, duty %u%% (%u cycles)\n",
+            (unsigned)record.carrier.frequencyHz,
+            (unsigned)record.carrier.dutyPercent,
+            (unsigned)record.carrier.cycles);
+    } else {
+        out.println(F("Carrier: none seen"));
+    }
+#endif  // CARRIER_METER
+
+    // The rest is about this receiver, not the code
+    if (g_settings.verbosity < kVerbosityStats) {
+        return;
+    }
+
+    // Ex. "Decode : 412 us"
+    out.printf("Decode : %u us\n", (unsigned)record.decodeMicros);
+
+#if FRAME_TIMING
+    // Ex. "Frame  : 67512 us, gap 41210 us"
+    out.printf("Frame  : %u us, ",
+        (unsigned)(record.times.endMicros - record.times.startMicros));
+    if (record.times.gapMicros) {
+        out.printf("gap %u us\n", (unsigned)record.times.gapMicros);
+    } else {
+        out.println(F("first frame"));
+    }
+
+    // Ex. "Marks  : 34, avg +52 us, worst +88 us from nominal"
+    MarkCheck check;
+    if (checkMarks(ir_results, &check)) {
+        out.printf("Marks  : %u, avg %+d us, worst %+d us from nominal\n",
+            (unsigned)check.marks,
+            (int)check.meanError,
+            (int)check.worstError);
+    }
+#endif  // FRAME_TIMING
+
+#if ADAPTIVE_TIMEOUT
+    // Ex. "Timeout: 15 ms (saved 75 ms)"
+    out.printf("Timeout: %u ms (saved %u ms)\n",
+        (unsigned)record.timeoutMs,
+        (unsigned)(g_adaptiveTimeout.longTimeoutMs() -
+                   min(record.timeoutMs, g_adaptiveTimeout.longTimeoutMs())));
+#endif  // ADAPTIVE_TIMEOUT
+
+    // Ex. "Queue  : 0 waiting, 3 max, 0 dropped", after this press
+    out.printf("Queue  : %u waiting, %u max, %u dropped\n",
+        (unsigned)(g_captureQueue.size() - pressLeft),
+        (unsigned)g_captureQueue.highWater(),
+        (unsigned)g_captureQueue.drops());
+
+    // Ex. "TX     : 1234 max buffered, 0 stalls"
+    out.printf("TX     : %u max buffered, %u stalls\n",
+        (unsigned)g_serialTx.highWater(),
+        (unsigned)g_serialTx.stalls());
+}
+
+/*
+outputStage
+
+Take the oldest button press off the capture queue (once it's complete, see
+PressGroup.h) and send it to Serial and the display: all of its frames in one
+BEGIN/END block and one screen update.  Only one press is handled per call,
+so loop() goes back to checking IRrecv in between each one.
+
+Nothing is started while the TX buffer is more than half full.
+
+Returns true if a press was output.
+*/
+bool outputStage() {
+    // Let the TX buffer catch up first, rather than fill it and have to wait
+    if (g_serialTx.pending() > (g_serialTx.capacity() / 2)) {
+        return false;
+    }
+
+    uint8_t frames = g_pressGroup.ready(g_captureQueue, millis());
+    if (frames == 0) {
+        return false;
+    }
+
+    uint32_t startCycles = ESP.getCycleCount();
+
+#if OUTPUT_FORMAT == OUTPUT_FORMAT_TEXT
+    g_serialTx.println("[====== ESP8266IRRecord - BEGIN ======]");
+
+    // Ex. "Press  : 2 frames over 162 ms"
+    if (frames > 1) {
+        ReportWriter out(g_serialTx);
+        out.printf("Press  : %u frames over %u ms\n",
+            (unsigned)frames,
+            (unsigned)(g_captureQueue.at(frames - 1)->captureMillis -
+                       g_captureQueue.front()->captureMillis));
+    }
+#endif  // OUTPUT_FORMAT
+
+    for (uint8_t frame = 0; frame < frames; frame++) {
+        const CaptureRecord *record = g_captureQueue.front();
+        uint32_t formatCycles = ESP.getCycleCount();
+
+        // The one decode_results for this capture, pointing at the queued
+        // record's raw timings rather than copying them, so it stays valid
+        // until pop().  Every stage below gets it and the record by
+        // reference.
+        decode_results results;
+        g_captureQueue.toResults(*record, &results);
+
+        // Its label, if it's a known button
+        const char *label = "";
+#if CODE_LIBRARY
+        CodeRecord known;
+        bool isKnown = g_codeLibrary.lookup(results.decode_type,
+                                            results.value, &known);
+        if (isKnown) {
+            label = known.label;
+        }
+#endif  // CODE_LIBRARY
+
+#if OUTPUT_FORMAT == OUTPUT_FORMAT_BINARY
+        // Still one frame per report, each has its own protocol and timings
+        {
+            ReportWriter out(g_serialTx);
+            printBinaryReport(out, results, *record);
+        }
+#else
+        // Ex. "[Frame 2 of 3]"
+        if (frames > 1) {
+            ReportWriter out(g_serialTx);
+            out.printf("[Frame %u of %u]\n", (unsigned)(frame + 1),
+                       (unsigned)frames);
+        }
+        printResults(*record, results, label, frames - frame);
+#endif  // OUTPUT_FORMAT
+        g_stageStats.add(kStageFormat,
+                         cyclesToMicros(ESP.getCycleCount() - formatCycles));
+
+        // Call routine to show simple output to SSD1306, drawn only, the
+        // whole press goes to the screen in one go below
+        uint32_t displayCycles = ESP.getCycleCount();
+        displayResults(*record, results, label);
+        g_stageStats.add(kStageDisplay,
+                         cyclesToMicros(ESP.getCycleCount() - displayCycles));
+
+#if NET_SINK
+        g_netSink.addCapture(results, *record);
+#endif  // NET_SINK
+
+#if CODE_LIBRARY
+        // Done after the output, it's a flash write
+        if (!isKnown) {
+            g_codeLibrary.add(results);
+        }
+#endif  // CODE_LIBRARY
+
+        g_captureQueue.pop();
+    }
+
+    g_scrollLog.show();
+
+#if OUTPUT_FORMAT == OUTPUT_FORMAT_TEXT
+    g_serialTx.println("[====== ESP8266IRRecord - END ======]");
+#endif  // OUTPUT_FORMAT
+
+    // Time how long until the last byte of this report is sent.  If the last
+    // report is still going, just keep timing that one.
+    if (!g_serialMarkPending) {
+        g_serialMarkPending = true;
+        g_serialMarkByte    = g_serialTx.totalWritten();
+        g_serialMarkCycles  = startCycles;
+    }
+
+    g_pressGroup.add(frames);
+
+#if HEAP_STATS
+    // Right after the report's Strings are gone, to catch the lowest point
+    g_heapStats.check();
+    g_heapStats.countCaptures(frames);
+#endif  // HEAP_STATS
+    return true;
+}
+
+/*
+repeatStage
+
+Report a button that was held down (see RepeatCache.h) once it's let go:
+one line to Serial instead of a full block per frame, and one to the screen.
+
+Ex. "[Repeat] XMP 0x170F443E14008300 (64 bits) x12 over 1320 ms"
+*/
+void repeatStage() {
+    // Same as outputStage(), don't add to a TX buffer that's behind already
+    if (g_serialTx.pending() > (g_serialTx.capacity() / 2)) {
+        return;
+    }
+
+    RepeatEntry entry;
+    if (!g_repeatCache.takeExpired(g_currentMillis, &entry)) {
+        return;
+    }
+
+    uint32_t heldMs = entry.lastMillis - entry.firstMillis;
+
+#if OUTPUT_FORMAT == OUTPUT_FORMAT_BINARY
+    {
+        ReportWriter out(g_serialTx);
+        printBinaryRepeat(out, entry);
+    }
+#else
+    {
+        decode_type_t decodeType = (decode_type_t)entry.decodeType;
+
+        ReportWriter out(g_serialTx);
+        out.print(F("[Repeat] "));
+        printProtocolName(out, decodeType);
+        if (!hasACState(decodeType)) {
+            out.print(F(" 0x"));
+            printUint64(out, entry.value, 16);
+        }
+        out.printf(" (%u bits) x%u over %u ms\n",
+            (unsigned)entry.bits,
+            (unsigned)entry.hits,
+            (unsigned)heldMs);
+    }
+#endif  // OUTPUT_FORMAT
+
+#if NET_SINK
+    g_netSink.addRepeat(entry);
+#endif  // NET_SINK
+
+    // Ex. "Repeated: x12 1320ms"
+    g_scrollLog.printf("Repeated: x%u %ums\n",
+                       (unsigned)entry.hits, (unsigned)heldMs);
+    g_scrollLog.show();
+}
+
+/*
+printStats
+
+The "[Stats]" lines, and everything printed along with them, for the last
+windowMs.  Nothing is reset here: statsStage() starts the next window after
+its periodic print, the console's "stats" command doesn't.
+*/
+void printStats(Print &out, uint32_t windowMs) {
+    (void)windowMs;  // Unless IDLE_SLEEP
+    g_stageStats.print(out);
+
+#if IDLE_SLEEP
+    // Ex. "[Idle] asleep 97.2% of 60000 ms (812 sleeps, 14 woken early)"
+    g_idleSleep.print(out, windowMs);
+#endif  // IDLE_SLEEP
+
+#if HEAP_STATS
+    // Ex. "[Heap] free 23456 (low 21000), largest 18000, frag 12%, ..."
+    g_heapStats.print(out, g_currentMillis);
+#endif  // HEAP_STATS
+
+    // Not reset, ex. "[Press] 40 presses, 64 frames, at most 3 in one"
+    g_pressGroup.print(out);
+
+#if SIGNATURE_INDEX
+    // Not reset, ex. "[Signature] 812 hits, 64 misses (93%), ..."
+    g_signatureIndex.print(out);
+#endif  // SIGNATURE_INDEX
+
+#if RAW_FILTER
+    // Not reset either, ex. "[Filter] 812 frames, 3140 glitches merged,
+    // 96 rejected (12 short, 40 no header, 44 noisy)"
+    g_rawFilter.print(out);
+#endif  // RAW_FILTER
+
+#if JITTER_HISTOGRAM
+    // Not reset, it keeps adding up since boot
+    g_jitterHistogram.print(out);
+#endif  // JITTER_HISTOGRAM
+
+#if CARRIER_METER
+    // Not reset, ex. "[Carrier] 48 frames, 2 with no carrier"
+    g_carrierMeter.print(out);
+#endif  // CARRIER_METER
+
+#if NET_SINK
+    // Ex. "[Net] up, 40 packets (112 captures) sent, 0 dropped"
+    out.printf("[Net] %s, %u packets (%u captures) sent, %u dropped\n",
+        g_netSink.connected() ? "up" : "down",
+        (unsigned)g_netSink.packetsSent(),
+        (unsigned)g_netSink.framesSent(),
+        (unsigned)g_netSink.packetsDropped());
+#endif  // NET_SINK
+}
+
+/*
+statsStage
+
+Finish timing the "serial" stage once the report's last byte has gone to
+the UART, and print the periodic "[Stats]" lines.
+*/
+void statsStage() {
+    if (g_serialMarkPending &&
+        ((int32_t)(g_serialTx.totalSent() - g_serialMarkByte) >= 0)) {
+        g_serialMarkPending = false;
+        g_stageStats.add(kStageSerial,
+            cyclesToMicros(ESP.getCycleCount() - g_serialMarkCycles));
+    }
+
+#if STAGE_STATS_INTERVAL_MS
+    if ((g_currentMillis - g_previousStatsMillis) > STAGE_STATS_INTERVAL_MS) {
+        uint32_t windowMs = g_currentMillis - g_previousStatsMillis;
+        g_previousStatsMillis = g_currentMillis;
+
+        ReportWriter out(g_serialTx);
+        printStats(out, windowMs);
+        g_stageStats.reset();
+
+#if IDLE_SLEEP
+        g_idleSleep.reset();
+#endif  // IDLE_SLEEP
+    }
+#endif  // STAGE_STATS_INTERVAL_MS
+}
+
+#if SELF_TEST
+/*
+selfTestStage
+
+Send the next loopback code if it's due (see LoopbackTest.h).  Only once the
+TX buffer has room, so a step's result line isn't held up behind a report.
+*/
+void selfTestStage() {
+    if (g_serialTx.pending() > (g_serialTx.capacity() / 2)) {
+        return;
+    }
+    ReportWriter out(g_serialTx);
+    g_loopback.poll(out);
+}
+#endif  // SELF_TEST
+
+#if IDLE_SLEEP
+/*
+idleStage
+
+If there's nothing left to do right now, sleep until there might be: a frame
+(IRrecv or EdgeCapture), a held button's repeat summary, the stats, or the
+next network batch, or the end of a press that's still coming in.  Anything
+in the TX buffer or still to go to the display means there's work now, so no
+sleep at all.
+*/
+void idleStage() {
+    if (g_serialTx.pending() || g_serialMarkPending ||
+        display.flushPending()) {
+        return;
+    }
+
+    unsigned long now = millis();
+    uint32_t sleepMs = IDLE_SLEEP_MAX_MS;
+
+    // A press still being received waits for the gap after its last frame
+    sleepMs = min(sleepMs, g_pressGroup.msUntilReady(g_captureQueue, now));
+
+#if EDGE_CAPTURE
+    // Mid-frame, sleep until it would time out (more edges push it back)
+    sleepMs = min(sleepMs, g_edgeCapture.msUntilFrame());
+#else
+    // IRrecv's timer ends the frame, so once it's started stay awake
+    if (!IdleSleep::irrecvIdle()) {
+        return;
+    }
+#endif  // EDGE_CAPTURE
+
+    sleepMs = min(sleepMs, g_repeatCache.msUntilExpired(now));
+
+#if STAGE_STATS_INTERVAL_MS
+    uint32_t sinceStats = now - g_previousStatsMillis;
+    sleepMs = min(sleepMs, (sinceStats > STAGE_STATS_INTERVAL_MS)
+        ? 0 : (uint32_t)(STAGE_STATS_INTERVAL_MS + 1 - sinceStats));
+#endif  // STAGE_STATS_INTERVAL_MS
+
+#if ADAPTIVE_TIMEOUT
+    // A new timeout waiting to be applied, keep checking for the quiet spell
+    if (g_adaptiveTimeout.timeoutMs(now) != g_receiverTimeoutMs) {
+        sleepMs = min(sleepMs, (uint32_t)IDLE_SLEEP_POLL_MS);
+    }
+#endif  // ADAPTIVE_TIMEOUT
+
+#if NET_SINK
+    sleepMs = min(sleepMs, g_netSink.msUntilPoll(now, kNetRetryMs));
+#endif  // NET_SINK
+
+#if SELF_TEST
+    sleepMs = min(sleepMs, g_loopback.msUntilPoll());
+#endif  // SELF_TEST
+
+#if EDGE_CAPTURE
+    g_idleSleep.sleep(sleepMs, NULL, sleepMs);
+#else
+    g_idleSleep.sleep(sleepMs, IdleSleep::irrecvIdle, IDLE_SLEEP_POLL_MS);
+#endif  // EDGE_CAPTURE
+}
+#endif  // IDLE_SLEEP
+
+#if BENCHMARK_MODE
+/*
+benchmarkStage
+
+One round of the benchmark: replay BENCHMARK_CAPTURES codes from the corpus
+(round robin) and send each through the capture queue and outputStage(),
+exactly like received codes, then print the results.
+
+Ex.
+[Bench] round 3: 100 captures (100 decoded) in 4210 ms = 23.7 per sec
+[Stats] decode : n=100 min=96 avg=412 max=1630 p99=1791 us
+...
+
+The rate includes the Serial output, so it depends heavily on the baud rate
+and OUTPUT_FORMAT.  The decode line is the decoders on their own.
+*/
+void benchmarkStage() {
+    static uint32_t roundNumber = 0;
+    uint32_t decoded = 0;
+    unsigned long startMillis = millis();
+
+    for (uint16_t n = 0; n < BENCHMARK_CAPTURES; n++) {
+        BenchCapture capture = benchCapture(n % kBenchCorpusSize);
+
+        uint32_t startCycles = ESP.getCycleCount();
+        bool ok = replayDecode(*irrecv, capture.rawUsecs, capture.rawLen,
+                               &g_DecodeResults);
+        uint32_t decodeMicros = cyclesToMicros(ESP.getCycleCount() -
+                                               startCycles);
+
+        g_currentMillis = millis();
+        if (ok) {
+            decoded++;
+            g_stageStats.add(kStageDecode, decodeMicros);
+            g_captureQueue.push(g_DecodeResults, g_currentMillis,
+                                g_receiverTimeoutMs, decodeMicros);
+            releaseCapture();
+        }
+
+        // Same as loop(), until this one has been output
+        while (g_captureQueue.size()) {
+            g_serialTx.drain();
+            statsStage();
+            if (!outputStage()) {
+                yield();
+            }
+            display.flushStep();
+        }
+    }
+
+    // Count the time to get the last report (and screen) out too
+    g_serialTx.flush();
+    display.flushDirty();
+    statsStage();
+
+#if SOAK_TEST
+    // Round after round with no summary of each, the periodic "[Stats]"
+    // and "[Heap]" lines from statsStage() are the results
+    return;
+#endif  // SOAK_TEST
+
+    uint32_t elapsed = max(millis() - startMillis, 1UL);
+    uint32_t perSecX10 = ((uint64_t)BENCHMARK_CAPTURES * 10000) / elapsed;
+
+    ReportWriter out(g_serialTx);
+    out.printf("[Bench] round %u: %u captures (%u decoded) in %u ms = "
+               "%u.%u per sec\n",
+               (unsigned)++roundNumber,
+               (unsigned)BENCHMARK_CAPTURES,
+               (unsigned)decoded,
+               (unsigned)elapsed,
+               (unsigned)(perSecX10 / 10),
+               (unsigned)(perSecX10 % 10));
+    g_stageStats.print(out);
+    out.flush();
+    g_serialTx.flush();
+    g_stageStats.reset();
+}
+#endif  // BENCHMARK_MODE
+
 /*
 loop
 
 Check for new IR codes and display results.
 
+Capturing and outputting are split in two stages with the capture queue in
+between, so a slow Serial dump doesn't stop new codes from being received.
+
 Originally, there were several yield() calls made here, but there's been no
 ill-effects with them removed, so leaving them out.  If the device starts
 failing the Watch Dog Timer (WDT), then they may need to be added back in.
@@ -241,79 +1521,45 @@ https://github.com/crankyoldgit/IRremoteESP8266/blob/master/examples/IRrecvDumpV
 */
 void loop() {
 
+#if BENCHMARK_MODE
+    benchmarkStage();
+    return;
+#endif  // BENCHMARK_MODE
+
     g_currentMillis = millis(); // To calculate elapsed time of IR codes recv'd
 
     // Check if the IR code has been received.
-    if (irrecv.decode(&g_DecodeResults) && !g_DecodeResults.repeat) {
-        Serial.println("[====== ESP8266IRRecord - BEGIN ======]");
+    captureStage();
 
-        // Check if we got an IR message that was to big for our capture buffer.
-        if (g_DecodeResults.overflow) {
-            Serial.printf(D_WARN_BUFFERFULL "\n", kCaptureBufferSize);
-        }
+    // Move whatever the UART can take right now, without waiting
+    g_serialTx.drain();
 
-        // Display the tolerance % if it has been changed from the default.
-        if  (kTolerancePercentage != kTolerance) {
-            Serial.printf(D_STR_TOLERANCE " : %d%%\n", kTolerancePercentage);
-        }
+#if CONSOLE
+    consoleStage();
+#endif  // CONSOLE
 
-        // Display the basic output of what we found.
-        Serial.println("[resultToHumanReadableBasic]:");
-        Serial.print(resultToHumanReadableBasic(&g_DecodeResults));
+    statsStage();
 
-        // Display any extra A/C info if we have it.
-        String description = IRAcUtils::resultAcToString(&g_DecodeResults);
-        if (description.length()) {
-            Serial.println("[resultsAcToString]:");
-            Serial.println(D_STR_MESGDESC ": " + description);
-        }
+#if ADAPTIVE_TIMEOUT
+    adaptTimeoutStage();
+#endif  // ADAPTIVE_TIMEOUT
 
-        // Output the results as source code
-        // From ....IRremoteESP8266\src\IRutils.cpp
-        Serial.println("[resultsToSourceCode]:");
-        Serial.println(resultToSourceCode(&g_DecodeResults));
-
-        // Ex. "Address: 0x04FB (4)"
-        if (g_DecodeResults.address) {
-            Serial.printf("Address: 0x%02X%02X (%d)\n",
-                g_DecodeResults.address,
-                (0xFF - g_DecodeResults.address),
-                g_DecodeResults.address);
-        }
+    if (!outputStage()) {
+        repeatStage();
+    }
 
-        // Ex. "Command: 0x02FD (2)"
-        if (g_DecodeResults.command) {
-            Serial.printf("Command: 0x%02X%02X (%d)\n",
-                g_DecodeResults.command,
-                (0xFF - g_DecodeResults.command),
-                g_DecodeResults.command);
-        }
+#if NET_SINK
+    g_netSink.poll(g_currentMillis);
+#endif  // NET_SINK
 
-        // Ex. "Value  : 0x0000000020DF40BF"
-        if (g_DecodeResults.value) {
-            Serial.printf("Value  : 0x%08X%08X\n",
-                ( (uint32_t)((g_DecodeResults.value >> 32) & 0xFFFFFFFF) ),
-                ( (uint32_t)(g_DecodeResults.value & 0xFFFFFFFF))
-            );
-        }
+#if SELF_TEST
+    selfTestStage();
+#endif  // SELF_TEST
 
-        // Call routine to show simple output to SSD1306
-        displayResults(g_DecodeResults);
+    // Send a little of any screen update, see DisplayLayer::flushStep()
+    display.flushStep();
 
-        Serial.println("[====== ESP8266IRRecord - END ======]");
-    } else {
-        // Draw a little 2x2 white square in bottom-right of screen, indicating
-        // it's ok to press button (which will cause screen to clear first)
-        if ((g_currentMillis - g_previousDisplayMillis) > 
-            CLEAR_AFTER_MILLISECONDS) {
-            display.fillRect(
-                                (SCREEN_WIDTH  - 2), // X
-                                (SCREEN_HEIGHT - 2), // Y
-                                2,                   // Width
-                                2,                   // Height
-                                SSD1306_WHITE        // Color SD1306 (just B/W)
-                            );
-            display.display();
-        }
-    }
+#if IDLE_SLEEP
+    idleStage();
+#endif  // IDLE_SLEEP
 }
@@ -0,0 +1,394 @@
+#!/usr/bin/env python3
+"""
+irrecord_binary.py
+
+Decoder for the ESP8266IRRecord binary capture framing (OUTPUT_FORMAT=1, see
+src/BinaryReport.h for the layout).
+
+Reads a serial port, a file of captured bytes, or stdin, finds each frame
+(sync bytes + valid CRC), and prints it as text, CSV or JSON lines.  Anything
+that isn't a valid frame (ex. the text the device prints at boot) is skipped.
+Held button "[Repeat]" summaries come out as rows with repeats/held_ms set.
+
+Examples:
+    python3 tools/irrecord_binary.py --port /dev/ttyUSB0
+    python3 tools/irrecord_binary.py --port COM5 --format csv > codes.csv
+    python3 tools/irrecord_binary.py capture.bin --format json
+    python3 tools/irrecord_binary.py --udp 5150 --format csv
+
+--udp collects the batched packets from receivers built with NET_SINK=1
+(src/NetSink.h), from any number of them at once; each record gets a
+"device" field with the receiver's chip id.
+
+Reading a serial port needs pyserial (pip install pyserial).  Everything else
+is standard library only.
+"""
+
+import argparse
+import csv
+import json
+import socket
+import sys
+
+SYNC = b"\xA5\x5A"
+# 1 sent every raw tick, 2 sends them RawCodec encoded (src/RawCodec.h)
+VERSIONS = (1, 2)
+RECORD_CAPTURE = 1
+RECORD_REPEAT = 2
+
+# UDP packets from NetSink (src/NetSink.h)
+NET_MAGIC = b"IR"
+NET_VERSION = 1
+NET_HEADER_SIZE = 12
+
+# CaptureRecord::flags (src/CaptureQueue.h)
+FLAG_OVERFLOW = 0x01
+FLAG_REPEAT = 0x02
+FLAG_RAW_TRUNCATED = 0x04
+# Payload only (src/BinaryReport.h)
+FLAG_HAS_STATE = 0x80
+FLAG_HAS_SOURCE = 0x40
+FLAG_HAS_TIMING = 0x20
+FLAG_HAS_CARRIER = 0x10
+
+CSV_FIELDS = ["millis", "protocol", "decode_type", "bits", "value",
+              "address", "command", "state", "flags", "raw_count", "raw",
+              "repeats", "held_ms", "device", "source", "start_us",
+              "frame_us", "gap_us", "carrier_hz", "duty_pct",
+              "carrier_cycles"]
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, same as crc16Update() on the device."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+
+class Reader:
+    """Little cursor over a payload."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def u8(self):
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def raw(self, count):
+        value = self.data[self.pos:self.pos + count]
+        if len(value) != count:
+            raise IndexError("payload too short")
+        self.pos += count
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.u8()
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def zvarint(self):
+        return unzigzag(self.varint())
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode_payload(payload):
+    """Turn one frame payload into a dict, or None if it isn't one we know."""
+    r = Reader(payload)
+    version = r.u8()
+    if version not in VERSIONS:
+        return None
+    kind = r.u8()
+    if kind == RECORD_REPEAT:
+        return _decode_repeat(r)
+    if kind != RECORD_CAPTURE:
+        return None
+
+    record = {"record": "capture", "flags": r.u8()}
+    record["decode_type"] = r.varint() - 1
+    record["protocol"] = r.raw(r.u8()).decode("ascii", "replace")
+    record["bits"] = r.varint()
+    record["millis"] = r.varint()
+    record["source"] = r.u8() if record["flags"] & FLAG_HAS_SOURCE else ""
+    record["start_us"] = record["frame_us"] = record["gap_us"] = ""
+    if record["flags"] & FLAG_HAS_TIMING:
+        record["start_us"] = r.varint()
+        record["frame_us"] = r.varint()
+        record["gap_us"] = r.varint()
+    record["carrier_hz"] = record["duty_pct"] = record["carrier_cycles"] = ""
+    if record["flags"] & FLAG_HAS_CARRIER:
+        record["carrier_hz"] = r.varint()
+        record["duty_pct"] = r.u8()
+        record["carrier_cycles"] = r.varint()
+
+    record["value"] = record["address"] = record["command"] = 0
+    record["state"] = ""
+    if record["flags"] & FLAG_HAS_STATE:
+        record["state"] = r.raw(r.u8()).hex().upper()
+    else:
+        record["value"] = r.varint()
+        record["address"] = r.varint()
+        record["command"] = r.varint()
+    record["flags"] &= ~(FLAG_HAS_STATE | FLAG_HAS_SOURCE | FLAG_HAS_TIMING |
+                         FLAG_HAS_CARRIER)
+
+    tick, raw = _decode_raw(r) if version == 1 else decode_raw_codec(r)
+    record["tick_us"] = tick
+    record["raw"] = raw
+    record["raw_count"] = len(raw)
+    record["repeats"] = record["held_ms"] = 0
+    return record
+
+
+def _decode_repeat(r):
+    """A held button summary (RepeatCache.h on the device)."""
+    record = {"record": "repeat", "flags": r.u8()}
+    record["decode_type"] = r.varint() - 1
+    record["protocol"] = r.raw(r.u8()).decode("ascii", "replace")
+    record["bits"] = r.varint()
+    record["value"] = r.varint()
+    record["millis"] = r.varint()
+    record["held_ms"] = r.varint()
+    record["repeats"] = r.varint()
+    if r.pos != len(r.data):
+        raise ValueError("trailing bytes")
+    record["has_state"] = bool(record["flags"] & FLAG_HAS_STATE)
+    record["flags"] = 0
+    record["address"] = record["command"] = 0
+    record["state"] = ""
+    record["tick_us"] = 0
+    record["raw"] = []
+    record["raw_count"] = 0
+    return record
+
+
+def _decode_raw(r):
+    tick = r.u8()
+    count = r.varint()
+    previous = [0, 0]
+    raw = []
+    for i in range(1, count + 1):
+        ticks = previous[i & 1] + r.zvarint()
+        if ticks < 0:
+            raise ValueError("negative timing")
+        previous[i & 1] = ticks
+        raw.append(ticks * tick)
+    if r.pos != len(r.data):
+        raise ValueError("trailing bytes")
+    return tick, raw
+
+
+def decode_raw_codec(r):
+    """Raw timings in RawCodec's encoding, same as decodeRaw()."""
+    quantum = r.u8()
+    count = r.varint()
+    previous = [0, 0]
+    raw = []
+    while len(raw) < count:
+        token = r.varint()
+        if token & 1:
+            repeat, delta = (token >> 1) + 2, 0
+        else:
+            repeat, delta = 1, unzigzag(token >> 1)
+        if len(raw) + repeat > count:
+            raise ValueError("run past the end")
+        for _ in range(repeat):
+            i = len(raw)
+            units = previous[i & 1] + delta
+            if units < 0:
+                raise ValueError("negative timing")
+            previous[i & 1] = units
+            raw.append(min(units * quantum, 0xFFFF))
+    if r.pos != len(r.data):
+        raise ValueError("trailing bytes")
+    return quantum, raw
+
+
+def iter_frames(chunks):
+    """Yield each valid payload found in an iterable of byte chunks."""
+    buf = bytearray()
+    for chunk in chunks:
+        buf.extend(chunk)
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                # Keep a trailing 0xA5 in case the 0x5A is in the next chunk
+                del buf[:max(0, len(buf) - 1)]
+                break
+            if start:
+                del buf[:start]
+            if len(buf) < 4:
+                break
+            length = buf[2] | (buf[3] << 8)
+            end = 4 + length + 2
+            if len(buf) < end:
+                break
+            body = bytes(buf[2:4 + length])
+            crc = buf[4 + length] | (buf[5 + length] << 8)
+            if crc16(body) == crc:
+                del buf[:end]
+                yield body[2:]
+            else:
+                # Not a real frame, resync one byte further on
+                del buf[:1]
+
+
+def iter_records(chunks):
+    for payload in iter_frames(chunks):
+        try:
+            record = decode_payload(payload)
+        except (IndexError, ValueError):
+            record = None
+        if record is not None:
+            yield record
+
+
+def iter_udp_records(port):
+    """Yield the records in every NetSink packet that arrives on port."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+
+    last_sequence = {}
+    while True:
+        data, _ = sock.recvfrom(65535)
+        if (len(data) < NET_HEADER_SIZE or data[:2] != NET_MAGIC or
+                data[2] != NET_VERSION):
+            continue
+
+        device = "%08X" % int.from_bytes(data[4:8], "little")
+        sequence = int.from_bytes(data[8:12], "little")
+        expected = last_sequence.get(device)
+        if expected is not None and sequence != expected:
+            sys.stderr.write("%s: %d packet(s) lost\n" % (
+                device, (sequence - expected) & 0xFFFFFFFF))
+        last_sequence[device] = (sequence + 1) & 0xFFFFFFFF
+
+        for record in iter_records([data[NET_HEADER_SIZE:]]):
+            record["device"] = device
+            yield record
+
+
+def format_text(record):
+    """Roughly the same as the device's text BEGIN/END block."""
+    if record["record"] == "repeat":
+        code = "" if record["has_state"] else " 0x%X" % record["value"]
+        return "[Repeat] %s%s (%d bits) x%d over %d ms" % (
+            record["protocol"], code, record["bits"], record["repeats"],
+            record["held_ms"])
+
+    raw = record["raw"]
+    lines = ["[====== ESP8266IRRecord - BEGIN ======]"]
+    if record["flags"] & FLAG_OVERFLOW:
+        lines.append("WARNING: IR code is too big for buffer.")
+    lines.append("Protocol  : %s%s" % (
+        record["protocol"],
+        " (Repeat)" if record["flags"] & FLAG_REPEAT else ""))
+    if record["source"] != "":
+        lines.append("Source : GPIO %d" % record["source"])
+    if record.get("frame_us", "") != "":
+        lines.append("Frame  : %d us, %s" % (
+            record["frame_us"],
+            "gap %d us" % record["gap_us"] if record["gap_us"]
+            else "first frame"))
+    if record.get("carrier_hz", "") != "":
+        lines.append("Carrier: %d Hz, duty %d%% (%d cycles)" % (
+            record["carrier_hz"], record["duty_pct"],
+            record["carrier_cycles"]))
+    if record["state"]:
+        code = "0x" + record["state"]
+    else:
+        code = "0x%X" % record["value"]
+    lines.append("Code      : %s (%d Bits)" % (code, record["bits"]))
+    lines.append("uint16_t rawData[%d] = {%s};  // %s" % (
+        len(raw), ", ".join(str(v) for v in raw), record["protocol"]))
+    if record["address"]:
+        lines.append("Address: 0x%02X%02X (%d)" % (
+            record["address"], (0xFF - record["address"]) & 0xFF,
+            record["address"]))
+    if record["command"]:
+        lines.append("Command: 0x%02X%02X (%d)" % (
+            record["command"], (0xFF - record["command"]) & 0xFF,
+            record["command"]))
+    if record["value"]:
+        lines.append("Value  : 0x%016X" % record["value"])
+    lines.append("[====== ESP8266IRRecord - END ======]")
+    return "\n".join(lines)
+
+
+def csv_row(record):
+    row = dict(record)
+    row["value"] = "0x%X" % record["value"]
+    row["address"] = "0x%X" % record["address"]
+    row["command"] = "0x%X" % record["command"]
+    row["raw"] = " ".join(str(v) for v in record["raw"])
+    return {k: row.get(k, "") for k in CSV_FIELDS}
+
+
+def open_source(args):
+    """Return an iterable of byte chunks from the chosen input."""
+    if args.port:
+        try:
+            import serial  # pyserial
+        except ImportError:
+            sys.exit("Reading a serial port needs pyserial: "
+                     "pip install pyserial")
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        return iter(lambda: port.read(4096), None)
+
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    return iter(lambda: stream.read(4096), b"")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode ESP8266IRRecord binary capture frames")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="file of captured bytes (default: stdin)")
+    parser.add_argument("--port", help="serial port to read instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--udp", type=int, metavar="PORT",
+                        help="collect NetSink packets on this UDP port")
+    parser.add_argument("--format", choices=["text", "csv", "json"],
+                        default="text")
+    args = parser.parse_args()
+
+    writer = None
+    if args.format == "csv":
+        writer = csv.DictWriter(sys.stdout, fieldnames=CSV_FIELDS)
+        writer.writeheader()
+
+    try:
+        if args.udp:
+            records = iter_udp_records(args.udp)
+        else:
+            records = iter_records(open_source(args))
+        for record in records:
+            if writer:
+                writer.writerow(csv_row(record))
+            elif args.format == "json":
+                print(json.dumps(record))
+            else:
+                print(format_text(record))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
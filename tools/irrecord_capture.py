@@ -0,0 +1,457 @@
+#!/usr/bin/env python3
+"""
+irrecord_capture.py
+
+Bulk capture tool for ESP8266IRRecord.  Reads the device's output (the text
+BEGIN/END blocks, the binary frames of OUTPUT_FORMAT=1, or a mix of both, ex.
+the boot text before the binary starts), puts each code back together, and
+writes them out as tables ready for a spreadsheet:
+
+    PREFIX.csv          One row per distinct code (protocol, bits, value or
+                        state), with how many times it was seen, when first
+                        and last, and the raw timings of its first capture.
+    PREFIX_all.csv      With --all, one row per capture as well.
+    PREFIX.parquet      With --parquet, the same tables as Parquet, raw
+    PREFIX_all.parquet  timings as a list column (needs pyarrow).
+
+The serial port is read on a thread of its own into a queue, so a slow disk
+or a busy terminal never leaves bytes sitting in the OS buffer until they're
+lost, which is what happens to long sessions in a serial monitor.  --log
+keeps a copy of every byte read, to run through this again later.
+
+The tables are written again every --every seconds and at the end (Ctrl-C),
+so a long session can be opened part way through.
+
+Examples:
+    python3 tools/irrecord_capture.py --port /dev/ttyUSB0 --out xr2
+    python3 tools/irrecord_capture.py --port COM5 --out vizio --all --parquet
+    python3 tools/irrecord_capture.py session.log --out session
+
+Reading a serial port needs pyserial (pip install pyserial), and --parquet
+needs pyarrow (pip install pyarrow).  Everything else is standard library
+only.  The binary frames are decoded by irrecord_binary.py, next to this.
+"""
+
+import argparse
+import csv
+import datetime
+import os
+import queue
+import re
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import irrecord_binary  # noqa: E402
+
+BEGIN_LINE = "[====== ESP8266IRRecord - BEGIN ======]"
+END_LINE = "[====== ESP8266IRRecord - END ======]"
+
+# Binary frames can't be longer than this (the length field is 16 bits), but
+# waiting for 64 KB after a false sync would hold up the text, so give up on
+# one well before that.
+MAX_FRAME_BYTES = 8192
+
+CODE_FIELDS = ["protocol", "decode_type", "bits", "value", "address",
+               "command", "state", "label", "count", "first_seen",
+               "last_seen", "raw_count", "raw"]
+CAPTURE_FIELDS = ["seen", "millis", "protocol", "decode_type", "bits",
+                  "value", "address", "command", "state", "label", "repeat",
+                  "overflow", "source", "frame_us", "gap_us", "carrier_hz",
+                  "duty_pct", "raw_count", "raw"]
+
+RE_PROTOCOL = re.compile(r"^Protocol\s*: (\S+)( \(Repeat\))?")
+RE_CODE = re.compile(r"^Code\s*: 0x([0-9A-F]+) \((\d+) Bits\)")
+RE_RAW = re.compile(r"^uint16_t rawData\[\d+\] = \{([^}]*)\};")
+RE_STATE = re.compile(r"^uint8_t state\[\d+\] = \{([^}]*)\};")
+RE_ADDRESS = re.compile(r"^uint32_t address = 0x([0-9A-F]+);")
+RE_COMMAND = re.compile(r"^uint32_t command = 0x([0-9A-F]+);")
+RE_DATA = re.compile(r"^uint64_t data = 0x([0-9A-F]+);")
+RE_ADDRESS_LINE = re.compile(r"^(Address|Command): 0x[0-9A-F]+ \((\d+)\)")
+RE_SOURCE = re.compile(r"^Source : GPIO (\d+)")
+RE_LABEL = re.compile(r"^Label  : (.*)$")
+RE_FRAME = re.compile(r"^Frame  : (\d+) us, (?:gap (\d+) us|first frame)")
+RE_CARRIER = re.compile(r"^Carrier: (\d+) Hz, duty (\d+)%")
+RE_FRAME_OF = re.compile(r"^\[Frame \d+ of \d+\]")
+
+
+def now_text():
+    return datetime.datetime.now().isoformat(timespec="milliseconds")
+
+
+class StreamSplitter:
+    """
+    Separates the binary frames from the text in a stream of byte chunks.
+    feed() returns a list of ("frame", payload) and ("text", line) items, in
+    the order they arrived.
+    """
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.text = bytearray()
+
+    def _text(self, data, items):
+        self.text.extend(data)
+        while True:
+            end = self.text.find(b"\n")
+            if end < 0:
+                break
+            line = bytes(self.text[:end]).rstrip(b"\r")
+            del self.text[:end + 1]
+            items.append(("text", line.decode("ascii", "replace")))
+
+    def feed(self, chunk):
+        items = []
+        self.buf.extend(chunk)
+        while self.buf:
+            start = self.buf.find(irrecord_binary.SYNC)
+            if start < 0:
+                # Keep a trailing 0xA5 in case the 0x5A is in the next chunk
+                keep = 1 if self.buf[-1:] == irrecord_binary.SYNC[:1] else 0
+                self._text(self.buf[:len(self.buf) - keep], items)
+                del self.buf[:len(self.buf) - keep]
+                break
+            if start:
+                self._text(self.buf[:start], items)
+                del self.buf[:start]
+            if len(self.buf) < 4:
+                break
+            length = self.buf[2] | (self.buf[3] << 8)
+            end = 4 + length + 2
+            if length > MAX_FRAME_BYTES:
+                self._text(self.buf[:1], items)
+                del self.buf[:1]
+                continue
+            if len(self.buf) < end:
+                break
+            body = bytes(self.buf[2:4 + length])
+            crc = self.buf[4 + length] | (self.buf[5 + length] << 8)
+            if irrecord_binary.crc16(body) == crc:
+                del self.buf[:end]
+                items.append(("frame", body[2:]))
+            else:
+                # Not a real frame, resync one byte further on
+                self._text(self.buf[:1], items)
+                del self.buf[:1]
+        return items
+
+
+class TextBlocks:
+    """
+    Puts the captures back together from the text BEGIN/END blocks.  One
+    block can hold several frames of one press ("[Frame n of m]" lines
+    between them, see src/PressGroup.h).
+    """
+
+    def __init__(self):
+        self.inside = False
+        self.capture = None
+        self.done = []
+
+    def _start(self):
+        self._finish()
+        self.capture = {"protocol": "", "decode_type": "", "bits": 0,
+                        "value": 0, "address": 0, "command": 0, "state": "",
+                        "label": "", "repeat": False, "overflow": False,
+                        "source": "", "frame_us": "", "gap_us": "",
+                        "carrier_hz": "", "duty_pct": "", "millis": "",
+                        "raw": []}
+
+    def _finish(self):
+        if self.capture is not None and self.capture["protocol"]:
+            self.done.append(self.capture)
+        self.capture = None
+
+    def line(self, text):
+        """Feed one line, returns the captures it completed."""
+        if text.startswith(BEGIN_LINE):
+            self.inside = True
+            self._start()
+        elif text.startswith(END_LINE):
+            self._finish()
+            self.inside = False
+        elif self.inside:
+            self._field(text)
+        done, self.done = self.done, []
+        return done
+
+    def _field(self, text):
+        if RE_FRAME_OF.match(text):
+            self._start()
+            return
+        capture = self.capture
+        if capture is None:
+            return
+        if text.startswith("WARNING"):
+            capture["overflow"] = True
+        m = RE_PROTOCOL.match(text)
+        if m:
+            capture["protocol"] = m.group(1)
+            capture["repeat"] = bool(m.group(2))
+            return
+        m = RE_CODE.match(text)
+        if m:
+            # The only place the code is at OUTPUT_VERBOSITY 0 and 1, the
+            # rawData[] lines (if any) come later and fill in the rest
+            capture["bits"] = int(m.group(2))
+            if len(m.group(1)) > 16:
+                capture["state"] = m.group(1)
+            else:
+                capture["value"] = int(m.group(1), 16)
+            return
+        m = RE_ADDRESS_LINE.match(text)
+        if m:
+            capture[m.group(1).lower()] = int(m.group(2))
+            return
+        m = RE_RAW.match(text)
+        if m:
+            capture["raw"] = [int(v) for v in m.group(1).split(",")
+                              if v.strip()]
+            return
+        m = RE_STATE.match(text)
+        if m:
+            capture["state"] = "".join(
+                "%02X" % int(v, 16) for v in m.group(1).split(","))
+            return
+        for regex, field in ((RE_ADDRESS, "address"), (RE_COMMAND, "command"),
+                             (RE_DATA, "value")):
+            m = regex.match(text)
+            if m:
+                capture[field] = int(m.group(1), 16)
+                return
+        m = RE_SOURCE.match(text)
+        if m:
+            capture["source"] = int(m.group(1))
+            return
+        m = RE_LABEL.match(text)
+        if m:
+            capture["label"] = m.group(1)
+            return
+        m = RE_FRAME.match(text)
+        if m:
+            capture["frame_us"] = int(m.group(1))
+            capture["gap_us"] = int(m.group(2) or 0)
+            return
+        m = RE_CARRIER.match(text)
+        if m:
+            capture["carrier_hz"] = int(m.group(1))
+            capture["duty_pct"] = int(m.group(2))
+
+
+def from_binary(record):
+    """A capture in the same shape as TextBlocks', from irrecord_binary."""
+    return {"protocol": record["protocol"],
+            "decode_type": record["decode_type"],
+            "bits": record["bits"], "value": record["value"],
+            "address": record["address"], "command": record["command"],
+            "state": record["state"], "label": "",
+            "repeat": bool(record["flags"] & irrecord_binary.FLAG_REPEAT),
+            "overflow": bool(record["flags"] &
+                             irrecord_binary.FLAG_OVERFLOW),
+            "source": record["source"], "frame_us": record["frame_us"],
+            "gap_us": record["gap_us"], "carrier_hz": record["carrier_hz"],
+            "duty_pct": record["duty_pct"], "millis": record["millis"],
+            "raw": record["raw"]}
+
+
+class Tables:
+    """Every capture, and the distinct codes among them."""
+
+    def __init__(self, keep_all):
+        self.keep_all = keep_all
+        self.captures = []
+        self.codes = {}
+        self.total = 0
+
+    def add(self, capture):
+        capture["seen"] = now_text()
+        self.total += 1
+        if self.keep_all:
+            self.captures.append(capture)
+
+        # Repeat frames say nothing about the button, and UNKNOWN "values"
+        # are hashes of noise, so neither is a code worth a row of its own
+        if capture["repeat"] or capture["protocol"] == "UNKNOWN":
+            return
+        key = (capture["protocol"], capture["bits"], capture["value"],
+               capture["state"])
+        code = self.codes.get(key)
+        if code is None:
+            code = dict(capture, count=0, first_seen=capture["seen"])
+            self.codes[key] = code
+        code["count"] += 1
+        code["last_seen"] = capture["seen"]
+        if capture["label"]:
+            code["label"] = capture["label"]
+        if code["decode_type"] == "":
+            code["decode_type"] = capture["decode_type"]  # Binary only
+
+
+def csv_value(field, value):
+    if field in ("value", "address", "command"):
+        return "0x%X" % value
+    if field == "raw":
+        return " ".join(str(v) for v in value)
+    return value
+
+
+def write_csv(path, fields, rows):
+    """Written to a temporary file first, so a reader never sees half."""
+    temp = path + ".tmp"
+    with open(temp, "w", newline="") as out:
+        writer = csv.DictWriter(out, fieldnames=fields)
+        writer.writeheader()
+        for row in rows:
+            writer.writerow({f: csv_value(f, row.get(f, "")) for f in fields})
+    os.replace(temp, path)
+
+
+def write_parquet(path, fields, rows):
+    import pyarrow
+    import pyarrow.parquet
+
+    columns = {}
+    for field in fields:
+        values = [row.get(field, "") for row in rows]
+        if field == "raw":
+            columns[field] = pyarrow.array(values,
+                                           pyarrow.list_(pyarrow.uint16()))
+        elif field in ("value", "address", "command", "count", "bits",
+                       "raw_count"):
+            columns[field] = pyarrow.array(values, pyarrow.uint64())
+        elif field in ("repeat", "overflow"):
+            columns[field] = pyarrow.array(values, pyarrow.bool_())
+        else:
+            columns[field] = pyarrow.array(
+                ["" if v == "" else str(v) for v in values], pyarrow.string())
+    temp = path + ".tmp"
+    pyarrow.parquet.write_table(pyarrow.table(columns), temp)
+    os.replace(temp, path)
+
+
+def write_tables(args, tables):
+    codes = list(tables.codes.values())
+    captures = tables.captures
+    for rows in (codes, captures):
+        for row in rows:
+            row["raw_count"] = len(row["raw"])
+
+    write_csv(args.out + ".csv", CODE_FIELDS, codes)
+    if args.all:
+        write_csv(args.out + "_all.csv", CAPTURE_FIELDS, captures)
+    if args.parquet:
+        write_parquet(args.out + ".parquet", CODE_FIELDS, codes)
+        if args.all:
+            write_parquet(args.out + "_all.parquet", CAPTURE_FIELDS,
+                          captures)
+
+
+def read_serial(port, baud, chunks, stop):
+    """The reader thread: nothing but port.read() into the queue."""
+    import serial  # pyserial
+    link = serial.Serial(port, baud, timeout=0.05)
+    if hasattr(link, "set_buffer_size"):
+        link.set_buffer_size(rx_size=1 << 20)  # Windows only
+    while not stop.is_set():
+        data = link.read(max(1, link.in_waiting))
+        if data:
+            chunks.put(data)
+    link.close()
+
+
+def iter_chunks(args, stop):
+    """Byte chunks from the chosen input, until it ends or Ctrl-C."""
+    if not args.port:
+        stream = (sys.stdin.buffer if args.input == "-"
+                  else open(args.input, "rb"))
+        for chunk in iter(lambda: stream.read(65536), b""):
+            yield chunk
+        return
+
+    try:
+        import serial  # noqa: F401 pyserial
+    except ImportError:
+        sys.exit("Reading a serial port needs pyserial: pip install pyserial")
+
+    chunks = queue.Queue()
+    reader = threading.Thread(target=read_serial,
+                              args=(args.port, args.baud, chunks, stop),
+                              daemon=True)
+    reader.start()
+    while reader.is_alive() or not chunks.empty():
+        try:
+            yield chunks.get(timeout=0.2)
+        except queue.Empty:
+            yield b""
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Collect ESP8266IRRecord captures into CSV/Parquet")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="file of captured output (default: stdin)")
+    parser.add_argument("--port", help="serial port to read instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--out", default="captures",
+                        help="file name prefix of the tables")
+    parser.add_argument("--all", action="store_true",
+                        help="also a table of every capture")
+    parser.add_argument("--parquet", action="store_true",
+                        help="also write Parquet (needs pyarrow)")
+    parser.add_argument("--log", help="append every byte read to this file")
+    parser.add_argument("--every", type=float, default=10.0,
+                        help="seconds between writing the tables")
+    args = parser.parse_args()
+
+    if args.parquet:
+        try:
+            import pyarrow.parquet  # noqa: F401
+        except ImportError:
+            sys.exit("--parquet needs pyarrow: pip install pyarrow")
+
+    log = open(args.log, "ab") if args.log else None
+    splitter = StreamSplitter()
+    blocks = TextBlocks()
+    tables = Tables(args.all)
+    stop = threading.Event()
+    last_write = time.monotonic()
+
+    try:
+        for chunk in iter_chunks(args, stop):
+            if log and chunk:
+                log.write(chunk)
+            for kind, item in splitter.feed(chunk):
+                if kind == "frame":
+                    try:
+                        record = irrecord_binary.decode_payload(item)
+                    except (IndexError, ValueError):
+                        record = None
+                    # Held button summaries aren't captures, they only say
+                    # how long the last one was held
+                    if record is not None and record["record"] == "capture":
+                        tables.add(from_binary(record))
+                else:
+                    for capture in blocks.line(item):
+                        tables.add(capture)
+
+            if time.monotonic() - last_write >= args.every:
+                last_write = time.monotonic()
+                write_tables(args, tables)
+                sys.stderr.write("\r%d captures, %d codes " % (
+                    tables.total, len(tables.codes)))
+                sys.stderr.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stop.set()
+        if log:
+            log.close()
+
+    write_tables(args, tables)
+    sys.stderr.write("\r%d captures, %d codes, written to %s.csv\n" % (
+        tables.total, len(tables.codes), args.out))
+
+
+if __name__ == "__main__":
+    main()